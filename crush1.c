@@ -8,6 +8,26 @@
 /* Subject a single DES PRNG to the TestU01 Crush test suite, DIEHARD
    and FIPS_140_2. It should pass all the tests! */
 
+/* The number of DES rounds, to test the reduced-round tiers, e.g. with
+   make -f Makefile.crush CFLAGS="-O2 -DDESPRNG_ROUNDS=8" crush1 */
+#ifndef DESPRNG_ROUNDS
+#define DESPRNG_ROUNDS 16
+#endif
+/* ...or the PRNG-only variant, with -DDESPRNG_NP1 */
+#ifdef DESPRNG_NP1
+#define MAKE_PRN make_prn_np1
+#elif DESPRNG_ROUNDS == 8
+#define MAKE_PRN make_prn8
+#elif DESPRNG_ROUNDS == 10
+#define MAKE_PRN make_prn10
+#elif DESPRNG_ROUNDS == 12
+#define MAKE_PRN make_prn12
+#elif DESPRNG_ROUNDS == 16
+#define MAKE_PRN make_prn
+#else
+#error "DESPRNG_ROUNDS must be 8, 10, 12 or 16"
+#endif
+
 unsigned desprng();
 desprng_common_t process_data;
 desprng_individual_t thread_data;
@@ -28,7 +48,11 @@ int main()
     initialize_common(&process_data);
     initialize_individual(&process_data, &thread_data, nident);
 
-    gen = unif01_CreateExternGenBits("DES PRNG", desprng);
+#ifdef DESPRNG_NP1
+    gen = unif01_CreateExternGenBits("PRNG-only DES PRNG (np1)", desprng);
+#else
+    gen = unif01_CreateExternGenBits(DESPRNG_ROUNDS == 16 ? "DES PRNG" : "Reduced-round DES PRNG", desprng);
+#endif
     bbattery_SmallCrush(gen);
     /* bbattery_Crush(gen); */
     /* bbattery_BigCrush(gen); */
@@ -46,7 +70,7 @@ unsigned desprng()
 
     if (icount++ % 2 == 0) /* For even icount, create new 8-byte pseudo-random number... */
     {
-        make_prn(&process_data, &thread_data, icount / 2, &iprn64);
+        MAKE_PRN(&process_data, &thread_data, icount / 2, &iprn64);
         return iprn32[0]; /* and return one half of it */
     }
     else /* For odd icount... */
@@ -0,0 +1,181 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include <sys/wait.h>
+#include <unif01.h>
+#include <swrite.h>
+#include <bbattery.h>
+
+#include "desprng.h"
+
+/* Subject many alternating pairs of DES PRNGs (as in crush2) to a TestU01
+ * battery, with the pairs sharded over Nshard processes (TestU01 is not
+ * thread safe). Pair k consists of the particle numbers nparticle + k and
+ * (nparticle + k) ^ (1 << (k % 56)), so the pairs cover adjacent-bit
+ * identifiers at every bit position. Each shard fills a buffer with the
+ * interleaved PRNs of a pair with make_prn_range(), and TestU01 reads its
+ * 32-bit halves from there. The p-values of every pair are written to
+ * crushpar.<shard>.out (and the TestU01 reports to crushpar.<shard>.log), and
+ * are summarized per test once all the shards are done.
+ *
+ * Usage: crushpar [battery [npair [nshard [nparticle]]]]
+ * battery is small (default), crush or big, npair defaults to 64, nshard to
+ * the number of online CPUs, and nparticle to a random number.
+ */
+
+#define Nbuffer 8192UL
+
+unsigned desprngs();
+desprng_common_t process_data;
+desprng_individual_t thread_data[2];
+unsigned long icount, ibuffer, buffer[2 * Nbuffer];
+
+/* Runs the battery on pairs ishard, ishard + nshard, ... and writes their p-values */
+static void shard(const char *battery, unsigned long nparticle, long npair, long ishard, long nshard)
+{
+    char filename[64];
+    unsigned long nident[2];
+    unif01_Gen *gen;
+    FILE *out;
+    long ipair;
+    int itest;
+
+    sprintf(filename, "crushpar.%ld.log", ishard);
+    assert(freopen(filename, "w", stdout));
+    sprintf(filename, "crushpar.%ld.out", ishard);
+    assert((out = fopen(filename, "w")));
+    swrite_Basic = FALSE;
+
+    for (ipair = ishard; ipair < npair; ipair += nshard)
+    {
+        nident[0] = (nparticle + ipair) & 0x00ffffffffffffffUL;
+        nident[1] = nident[0] ^ (1UL << (ipair % 56));
+        fprintf(out, "# pair %ld: particle numbers %014lX %014lX\n", ipair, nident[0], nident[1]);
+        assert(!create_identifier(nident));
+        assert(!create_identifier(nident + 1));
+        initialize_individual(&process_data, thread_data, nident[0]);
+        initialize_individual(&process_data, thread_data + 1, nident[1]);
+        icount = 0UL;
+        ibuffer = 4 * Nbuffer;
+
+        gen = unif01_CreateExternGenBits("Pair of DES PRNGs", desprngs);
+        if (!strcmp(battery, "crush"))
+            bbattery_Crush(gen);
+        else if (!strcmp(battery, "big"))
+            bbattery_BigCrush(gen);
+        else
+            bbattery_SmallCrush(gen);
+        unif01_DeleteExternGenBits(gen);
+
+        for (itest = 0; itest < bbattery_NTests; itest++)
+            fprintf(out, "%ld %d %.6e %s\n", ipair, itest, bbattery_pVal[itest], bbattery_TestNames[itest]);
+        fflush(out);
+    }
+    fclose(out);
+    fflush(stdout);
+
+    return;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *battery = argc > 1 ? argv[1] : "small";
+    long npair = argc > 2 ? atol(argv[2]) : 64, nshard = argc > 3 ? atol(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN), ishard;
+    unsigned long nparticle = 0UL;
+    /* Per test: the number of p-values, the suspect (outside [0.001, 0.999]) ones, and the extremes */
+    long ntests = 0, itest, count[256] = {0}, nsuspect[256] = {0}, ipair, total = 0, totalsuspect = 0;
+    double pmin[256], pmax[256], pvalue;
+    char filename[64], line[256], name[256][64];
+    FILE *in;
+    int status, failed = 0;
+
+    if (argc > 4)
+        nparticle = strtoul(argv[4], NULL, 0);
+    else
+        /* Get a proper (not pseudo) 7-byte random number from the /dev/random device */
+        assert(7 == getrandom(&nparticle, 7, GRND_RANDOM));
+    if (nshard < 1) nshard = 1;
+    if (nshard > npair) nshard = npair;
+    initialize_common(&process_data);
+
+    printf("Running the %s battery on %ld pairs of DES PRNGs in %ld processes, from particle number %014lX\n",
+           battery, npair, nshard, nparticle & 0x00ffffffffffffffUL);
+    fflush(stdout);
+    for (ishard = 0; ishard < nshard; ishard++)
+    {
+        pid_t pid = fork();
+
+        assert(pid >= 0);
+        if (!pid)
+        {
+            shard(battery, nparticle, npair, ishard, nshard);
+            _exit(0);
+        }
+    }
+    while (wait(&status) > 0)
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) failed = 1;
+    if (failed) fprintf(stderr, "Some shards failed, see crushpar.*.log\n");
+
+    /* Aggregate the p-values of all the shards, per test */
+    for (itest = 0; itest < 256; itest++)
+    {
+        pmin[itest] = 1.0;
+        pmax[itest] = 0.0;
+    }
+    for (ishard = 0; ishard < nshard; ishard++)
+    {
+        sprintf(filename, "crushpar.%ld.out", ishard);
+        if (!(in = fopen(filename, "r"))) continue;
+        while (fgets(line, sizeof(line), in))
+        {
+            if (line[0] == '#' || sscanf(line, "%ld %ld %lf", &ipair, &itest, &pvalue) != 3 || itest < 0 || itest >= 256) continue;
+            if (itest >= ntests)
+            {
+                sscanf(line, "%*d %*d %*s %63[^\n]", name[itest]);
+                ntests = itest + 1;
+            }
+            /* TestU01 stores -1 for the statistics it did not compute */
+            if (pvalue < 0.0) continue;
+            count[itest]++;
+            if (pvalue < 0.001 || pvalue > 0.999) nsuspect[itest]++;
+            if (pvalue < pmin[itest]) pmin[itest] = pvalue;
+            if (pvalue > pmax[itest]) pmax[itest] = pvalue;
+        }
+        fclose(in);
+    }
+
+    printf("\n  #  Test                               p-values  suspect      min p      max p\n");
+    for (itest = 0; itest < ntests; itest++)
+    {
+        if (!count[itest]) continue;
+        printf("%3ld  %-32s %9ld %8ld  %9.3e  %9.3e\n", itest, name[itest], count[itest], nsuspect[itest], pmin[itest], pmax[itest]);
+        total += count[itest];
+        totalsuspect += nsuspect[itest];
+    }
+    printf("\n%ld suspect p-values out of %ld (%.1f expected by chance)\n", totalsuspect, total, 0.002 * total);
+
+    return failed;
+}
+
+unsigned desprngs()
+{
+    /* Refill the buffer with the next Nbuffer PRNs of each PRNG of the pair, interleaved */
+    if (ibuffer == 4 * Nbuffer)
+    {
+        unsigned long i, iprn[Nbuffer];
+        int j;
+
+        for (j = 0; j < 2; j++)
+        {
+            make_prn_range(&process_data, thread_data + j, icount, Nbuffer, iprn);
+            for (i = 0UL; i < Nbuffer; i++) buffer[2 * i + j] = iprn[i];
+        }
+        icount += Nbuffer;
+        ibuffer = 0UL;
+    }
+    /* Return the halves of each 8-byte PRN in the same order as crush2 does */
+    return ((unsigned *)buffer)[ibuffer++];
+}
@@ -21,20 +21,99 @@
 
 #include "desprng.h"
 
+/* Number of independent blocks that _desrange() encrypts side by side */
+#define DES_INTERLEAVE 4
+
+/* The word-level block functions (_wordin() and _wordout()) need to know the
+   byte order, which otherwise only matters for the byte-wise _scrunch() and
+   _unscrun(). Without __BYTE_ORDER__, little endian is assumed */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define DES_BIG_ENDIAN
+#endif
+
 /* Signatures for the modified d3des functions that are internal (hence, static) to libdesprng.a */
 #pragma acc routine(_usekey) seq
 static void _usekey(desprng_individual_t *thread_data, unsigned long *from);
 #pragma acc routine(_cookey) seq
-static void _cookey(desprng_individual_t *thread_data, unsigned long *raw1);
-#pragma acc routine(_scrunch) seq
-static void _scrunch(unsigned char *outof, unsigned long *into);
-#pragma acc routine(_unscrun) seq
-static void _unscrun(unsigned long *outof, unsigned char *into);
+static void _cookey(unsigned long *raw1, unsigned long *cook);
+#pragma acc routine(_deskn) seq
+static void _deskn(desprng_common_t *process_data, unsigned char *key, unsigned long *cook);
+#pragma acc routine(_despc1) seq
+static unsigned long _despc1(unsigned char *key);
+#pragma acc routine(_despc2) seq
+static unsigned long _despc2(unsigned long c, unsigned long d);
+#pragma acc routine(_desknfast) seq
+static void _desknfast(desprng_common_t *process_data, unsigned char *key, unsigned long *cook);
+#pragma acc routine(_desf) seq
+static unsigned long _desf(desprng_common_t *process_data, unsigned long right, unsigned long key0, unsigned long key1);
 #pragma acc routine(_desfunc) seq
 static void _desfunc(desprng_common_t *process_data, unsigned long *block, unsigned long *keys);
+#pragma acc routine(_desfuncr) seq
+static void _desfuncr(desprng_common_t *process_data, unsigned long *block, unsigned long *keys, int rounds);
+#pragma acc routine(_desfunc32) seq
+static void _desfunc32(desprng_common_t *process_data, unsigned long *block, unsigned *keys);
+#pragma acc routine(_desftab) seq
+static unsigned long _desftab(desprng_table_t *table_data, unsigned long right, unsigned long key0, unsigned long key1);
+#pragma acc routine(_desfunctab) seq
+static void _desfunctab(desprng_table_t *table_data, unsigned long *block, unsigned *keys);
+#pragma acc routine(_desswap) seq
+static unsigned long _desswap(unsigned long word);
+#pragma acc routine(_wordin) seq
+static void _wordin(unsigned long word, unsigned long *block);
+#pragma acc routine(_wordout) seq
+static unsigned long _wordout(unsigned long *block);
+#pragma acc routine(_desfpair) seq
+static unsigned long _desfpair(desprng_pairtable_t *pairtable_data, unsigned long right, unsigned long key0, unsigned long key1);
+#pragma acc routine(_desfuncpair) seq
+static void _desfuncpair(desprng_pairtable_t *pairtable_data, unsigned long *block, unsigned *keys);
+
+/* Signatures for the functions that are also called by the other backends in libdesprng.a */
+#pragma acc routine(_scrunch) seq
+void _scrunch(unsigned char *outof, unsigned long *into);
+#pragma acc routine(_unscrun) seq
+void _unscrun(unsigned long *outof, unsigned char *into);
+#pragma acc routine(_desip) seq
+void _desip(unsigned long *block);
+#pragma acc routine(_desfp) seq
+void _desfp(unsigned long *block);
+
+#pragma acc routine seq
+void _deskey(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key)
+{
+    unsigned long dough[32];
+
+    _deskn(process_data, key, dough);
+    _usekey(thread_data, dough);
+
+    return;
+}
+
+/* Same as _deskey(), but with the tables in desprng_common_t */
+#pragma acc routine seq
+void _deskeyfast(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key)
+{
+    unsigned long dough[32];
+
+    _desknfast(process_data, key, dough);
+    _usekey(thread_data, dough);
 
+    return;
+}
+
+/* Same as _deskeyfast(), but for the compact state with 32-bit subkeys */
 #pragma acc routine seq
-void _deskey(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key) /* Thanks to James Gillogly & Phil Karn! */
+void _deskey32(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned char *key)
+{
+    unsigned long dough[32];
+    int i;
+
+    _desknfast(process_data, key, dough);
+    for (i = 0; i < 32; i++) compact_data->KnL[i] = dough[i];
+
+    return;
+}
+
+static void _deskn(desprng_common_t *process_data, unsigned char *key, unsigned long *cook) /* Thanks to James Gillogly & Phil Karn! */
 {
     int i, j, l, m, n;
     unsigned char pc1m[56], pcr[56];
@@ -69,18 +148,453 @@ void _deskey(desprng_common_t *process_data, desprng_individual_t *thread_data,
             if (pcr[process_data->pc2[j + 24]]) kn[n] |= process_data->bigbyte[j];
         }
     }
-    _cookey(thread_data, kn);
+    _cookey(kn, cook);
 
     return;
 }
 
-static void _cookey(desprng_individual_t *thread_data, unsigned long *raw1)
+/* Constant tables for the fast key schedule (10 kB), computed once from pc1,
+   pc2, bytebit and bigbyte (as used by _deskn()) and by _cookey().
+   _PC1[b][v] holds the bits of C << 28 | D set by the value v of nibble b of
+   the key (counting from the most significant nibble of key[0]), i.e. bit
+   55 - j of C << 28 | D is pc1m[j] in _deskn().
+   _PC2[b][v] holds the pair of cooked subkeys (KnL[2i] << 32 | KnL[2i + 1])
+   set by the value v of bits 27 - 7b to 21 - 7b of C (b < 4) or of D (b >= 4)
+   after the rotation of round i. _deskeyfast() is checked against _deskey()
+   by oldnewcomparison */
+static const unsigned long _PC1[16][16] =
 {
-    unsigned long *cook, *raw0;
-    unsigned long dough[32];
+    {
+        0x0000000000000000UL, 0x0000000000000001UL, 0x0000000100000000UL, 0x0000000100000001UL,
+        0x0000010000000000UL, 0x0000010000000001UL, 0x0000010100000000UL, 0x0000010100000001UL,
+        0x0001000000000000UL, 0x0001000000000001UL, 0x0001000100000000UL, 0x0001000100000001UL,
+        0x0001010000000000UL, 0x0001010000000001UL, 0x0001010100000000UL, 0x0001010100000001UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000000100000UL, 0x0000000000100000UL,
+        0x0000000000001000UL, 0x0000000000001000UL, 0x0000000000101000UL, 0x0000000000101000UL,
+        0x0000000000000010UL, 0x0000000000000010UL, 0x0000000000100010UL, 0x0000000000100010UL,
+        0x0000000000001010UL, 0x0000000000001010UL, 0x0000000000101010UL, 0x0000000000101010UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000002UL, 0x0000000200000000UL, 0x0000000200000002UL,
+        0x0000020000000000UL, 0x0000020000000002UL, 0x0000020200000000UL, 0x0000020200000002UL,
+        0x0002000000000000UL, 0x0002000000000002UL, 0x0002000200000000UL, 0x0002000200000002UL,
+        0x0002020000000000UL, 0x0002020000000002UL, 0x0002020200000000UL, 0x0002020200000002UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000000200000UL, 0x0000000000200000UL,
+        0x0000000000002000UL, 0x0000000000002000UL, 0x0000000000202000UL, 0x0000000000202000UL,
+        0x0000000000000020UL, 0x0000000000000020UL, 0x0000000000200020UL, 0x0000000000200020UL,
+        0x0000000000002020UL, 0x0000000000002020UL, 0x0000000000202020UL, 0x0000000000202020UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000004UL, 0x0000000400000000UL, 0x0000000400000004UL,
+        0x0000040000000000UL, 0x0000040000000004UL, 0x0000040400000000UL, 0x0000040400000004UL,
+        0x0004000000000000UL, 0x0004000000000004UL, 0x0004000400000000UL, 0x0004000400000004UL,
+        0x0004040000000000UL, 0x0004040000000004UL, 0x0004040400000000UL, 0x0004040400000004UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000000400000UL, 0x0000000000400000UL,
+        0x0000000000004000UL, 0x0000000000004000UL, 0x0000000000404000UL, 0x0000000000404000UL,
+        0x0000000000000040UL, 0x0000000000000040UL, 0x0000000000400040UL, 0x0000000000400040UL,
+        0x0000000000004040UL, 0x0000000000004040UL, 0x0000000000404040UL, 0x0000000000404040UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000008UL, 0x0000000800000000UL, 0x0000000800000008UL,
+        0x0000080000000000UL, 0x0000080000000008UL, 0x0000080800000000UL, 0x0000080800000008UL,
+        0x0008000000000000UL, 0x0008000000000008UL, 0x0008000800000000UL, 0x0008000800000008UL,
+        0x0008080000000000UL, 0x0008080000000008UL, 0x0008080800000000UL, 0x0008080800000008UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000000800000UL, 0x0000000000800000UL,
+        0x0000000000008000UL, 0x0000000000008000UL, 0x0000000000808000UL, 0x0000000000808000UL,
+        0x0000000000000080UL, 0x0000000000000080UL, 0x0000000000800080UL, 0x0000000000800080UL,
+        0x0000000000008080UL, 0x0000000000008080UL, 0x0000000000808080UL, 0x0000000000808080UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000010000000UL, 0x0000001000000000UL, 0x0000001010000000UL,
+        0x0000100000000000UL, 0x0000100010000000UL, 0x0000101000000000UL, 0x0000101010000000UL,
+        0x0010000000000000UL, 0x0010000010000000UL, 0x0010001000000000UL, 0x0010001010000000UL,
+        0x0010100000000000UL, 0x0010100010000000UL, 0x0010101000000000UL, 0x0010101010000000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000001000000UL, 0x0000000001000000UL,
+        0x0000000000010000UL, 0x0000000000010000UL, 0x0000000001010000UL, 0x0000000001010000UL,
+        0x0000000000000100UL, 0x0000000000000100UL, 0x0000000001000100UL, 0x0000000001000100UL,
+        0x0000000000010100UL, 0x0000000000010100UL, 0x0000000001010100UL, 0x0000000001010100UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000020000000UL, 0x0000002000000000UL, 0x0000002020000000UL,
+        0x0000200000000000UL, 0x0000200020000000UL, 0x0000202000000000UL, 0x0000202020000000UL,
+        0x0020000000000000UL, 0x0020000020000000UL, 0x0020002000000000UL, 0x0020002020000000UL,
+        0x0020200000000000UL, 0x0020200020000000UL, 0x0020202000000000UL, 0x0020202020000000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000002000000UL, 0x0000000002000000UL,
+        0x0000000000020000UL, 0x0000000000020000UL, 0x0000000002020000UL, 0x0000000002020000UL,
+        0x0000000000000200UL, 0x0000000000000200UL, 0x0000000002000200UL, 0x0000000002000200UL,
+        0x0000000000020200UL, 0x0000000000020200UL, 0x0000000002020200UL, 0x0000000002020200UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000040000000UL, 0x0000004000000000UL, 0x0000004040000000UL,
+        0x0000400000000000UL, 0x0000400040000000UL, 0x0000404000000000UL, 0x0000404040000000UL,
+        0x0040000000000000UL, 0x0040000040000000UL, 0x0040004000000000UL, 0x0040004040000000UL,
+        0x0040400000000000UL, 0x0040400040000000UL, 0x0040404000000000UL, 0x0040404040000000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000004000000UL, 0x0000000004000000UL,
+        0x0000000000040000UL, 0x0000000000040000UL, 0x0000000004040000UL, 0x0000000004040000UL,
+        0x0000000000000400UL, 0x0000000000000400UL, 0x0000000004000400UL, 0x0000000004000400UL,
+        0x0000000000040400UL, 0x0000000000040400UL, 0x0000000004040400UL, 0x0000000004040400UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000080000000UL, 0x0000008000000000UL, 0x0000008080000000UL,
+        0x0000800000000000UL, 0x0000800080000000UL, 0x0000808000000000UL, 0x0000808080000000UL,
+        0x0080000000000000UL, 0x0080000080000000UL, 0x0080008000000000UL, 0x0080008080000000UL,
+        0x0080800000000000UL, 0x0080800080000000UL, 0x0080808000000000UL, 0x0080808080000000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000008000000UL, 0x0000000008000000UL,
+        0x0000000000080000UL, 0x0000000000080000UL, 0x0000000008080000UL, 0x0000000008080000UL,
+        0x0000000000000800UL, 0x0000000000000800UL, 0x0000000008000800UL, 0x0000000008000800UL,
+        0x0000000000080800UL, 0x0000000000080800UL, 0x0000000008080800UL, 0x0000000008080800UL
+    }
+};
+static const unsigned long _PC2[8][128] =
+{
+    {
+        0x0000000000000000UL, 0x0000000000100000UL, 0x0000000004000000UL, 0x0000000004100000UL,
+        0x0100000000000000UL, 0x0100000000100000UL, 0x0100000004000000UL, 0x0100000004100000UL,
+        0x0004000000000000UL, 0x0004000000100000UL, 0x0004000004000000UL, 0x0004000004100000UL,
+        0x0104000000000000UL, 0x0104000000100000UL, 0x0104000004000000UL, 0x0104000004100000UL,
+        0x0000000020000000UL, 0x0000000020100000UL, 0x0000000024000000UL, 0x0000000024100000UL,
+        0x0100000020000000UL, 0x0100000020100000UL, 0x0100000024000000UL, 0x0100000024100000UL,
+        0x0004000020000000UL, 0x0004000020100000UL, 0x0004000024000000UL, 0x0004000024100000UL,
+        0x0104000020000000UL, 0x0104000020100000UL, 0x0104000024000000UL, 0x0104000024100000UL,
+        0x0000000000010000UL, 0x0000000000110000UL, 0x0000000004010000UL, 0x0000000004110000UL,
+        0x0100000000010000UL, 0x0100000000110000UL, 0x0100000004010000UL, 0x0100000004110000UL,
+        0x0004000000010000UL, 0x0004000000110000UL, 0x0004000004010000UL, 0x0004000004110000UL,
+        0x0104000000010000UL, 0x0104000000110000UL, 0x0104000004010000UL, 0x0104000004110000UL,
+        0x0000000020010000UL, 0x0000000020110000UL, 0x0000000024010000UL, 0x0000000024110000UL,
+        0x0100000020010000UL, 0x0100000020110000UL, 0x0100000024010000UL, 0x0100000024110000UL,
+        0x0004000020010000UL, 0x0004000020110000UL, 0x0004000024010000UL, 0x0004000024110000UL,
+        0x0104000020010000UL, 0x0104000020110000UL, 0x0104000024010000UL, 0x0104000024110000UL,
+        0x0200000000000000UL, 0x0200000000100000UL, 0x0200000004000000UL, 0x0200000004100000UL,
+        0x0300000000000000UL, 0x0300000000100000UL, 0x0300000004000000UL, 0x0300000004100000UL,
+        0x0204000000000000UL, 0x0204000000100000UL, 0x0204000004000000UL, 0x0204000004100000UL,
+        0x0304000000000000UL, 0x0304000000100000UL, 0x0304000004000000UL, 0x0304000004100000UL,
+        0x0200000020000000UL, 0x0200000020100000UL, 0x0200000024000000UL, 0x0200000024100000UL,
+        0x0300000020000000UL, 0x0300000020100000UL, 0x0300000024000000UL, 0x0300000024100000UL,
+        0x0204000020000000UL, 0x0204000020100000UL, 0x0204000024000000UL, 0x0204000024100000UL,
+        0x0304000020000000UL, 0x0304000020100000UL, 0x0304000024000000UL, 0x0304000024100000UL,
+        0x0200000000010000UL, 0x0200000000110000UL, 0x0200000004010000UL, 0x0200000004110000UL,
+        0x0300000000010000UL, 0x0300000000110000UL, 0x0300000004010000UL, 0x0300000004110000UL,
+        0x0204000000010000UL, 0x0204000000110000UL, 0x0204000004010000UL, 0x0204000004110000UL,
+        0x0304000000010000UL, 0x0304000000110000UL, 0x0304000004010000UL, 0x0304000004110000UL,
+        0x0200000020010000UL, 0x0200000020110000UL, 0x0200000024010000UL, 0x0200000024110000UL,
+        0x0300000020010000UL, 0x0300000020110000UL, 0x0300000024010000UL, 0x0300000024110000UL,
+        0x0204000020010000UL, 0x0204000020110000UL, 0x0204000024010000UL, 0x0204000024110000UL,
+        0x0304000020010000UL, 0x0304000020110000UL, 0x0304000024010000UL, 0x0304000024110000UL
+    },
+    {
+        0x0000000000000000UL, 0x2000000000000000UL, 0x0000000000020000UL, 0x2000000000020000UL,
+        0x0008000000000000UL, 0x2008000000000000UL, 0x0008000000020000UL, 0x2008000000020000UL,
+        0x0800000000000000UL, 0x2800000000000000UL, 0x0800000000020000UL, 0x2800000000020000UL,
+        0x0808000000000000UL, 0x2808000000000000UL, 0x0808000000020000UL, 0x2808000000020000UL,
+        0x0000000001000000UL, 0x2000000001000000UL, 0x0000000001020000UL, 0x2000000001020000UL,
+        0x0008000001000000UL, 0x2008000001000000UL, 0x0008000001020000UL, 0x2008000001020000UL,
+        0x0800000001000000UL, 0x2800000001000000UL, 0x0800000001020000UL, 0x2800000001020000UL,
+        0x0808000001000000UL, 0x2808000001000000UL, 0x0808000001020000UL, 0x2808000001020000UL,
+        0x0000000000000000UL, 0x2000000000000000UL, 0x0000000000020000UL, 0x2000000000020000UL,
+        0x0008000000000000UL, 0x2008000000000000UL, 0x0008000000020000UL, 0x2008000000020000UL,
+        0x0800000000000000UL, 0x2800000000000000UL, 0x0800000000020000UL, 0x2800000000020000UL,
+        0x0808000000000000UL, 0x2808000000000000UL, 0x0808000000020000UL, 0x2808000000020000UL,
+        0x0000000001000000UL, 0x2000000001000000UL, 0x0000000001020000UL, 0x2000000001020000UL,
+        0x0008000001000000UL, 0x2008000001000000UL, 0x0008000001020000UL, 0x2008000001020000UL,
+        0x0800000001000000UL, 0x2800000001000000UL, 0x0800000001020000UL, 0x2800000001020000UL,
+        0x0808000001000000UL, 0x2808000001000000UL, 0x0808000001020000UL, 0x2808000001020000UL,
+        0x0001000000000000UL, 0x2001000000000000UL, 0x0001000000020000UL, 0x2001000000020000UL,
+        0x0009000000000000UL, 0x2009000000000000UL, 0x0009000000020000UL, 0x2009000000020000UL,
+        0x0801000000000000UL, 0x2801000000000000UL, 0x0801000000020000UL, 0x2801000000020000UL,
+        0x0809000000000000UL, 0x2809000000000000UL, 0x0809000000020000UL, 0x2809000000020000UL,
+        0x0001000001000000UL, 0x2001000001000000UL, 0x0001000001020000UL, 0x2001000001020000UL,
+        0x0009000001000000UL, 0x2009000001000000UL, 0x0009000001020000UL, 0x2009000001020000UL,
+        0x0801000001000000UL, 0x2801000001000000UL, 0x0801000001020000UL, 0x2801000001020000UL,
+        0x0809000001000000UL, 0x2809000001000000UL, 0x0809000001020000UL, 0x2809000001020000UL,
+        0x0001000000000000UL, 0x2001000000000000UL, 0x0001000000020000UL, 0x2001000000020000UL,
+        0x0009000000000000UL, 0x2009000000000000UL, 0x0009000000020000UL, 0x2009000000020000UL,
+        0x0801000000000000UL, 0x2801000000000000UL, 0x0801000000020000UL, 0x2801000000020000UL,
+        0x0809000000000000UL, 0x2809000000000000UL, 0x0809000000020000UL, 0x2809000000020000UL,
+        0x0001000001000000UL, 0x2001000001000000UL, 0x0001000001020000UL, 0x2001000001020000UL,
+        0x0009000001000000UL, 0x2009000001000000UL, 0x0009000001020000UL, 0x2009000001020000UL,
+        0x0801000001000000UL, 0x2801000001000000UL, 0x0801000001020000UL, 0x2801000001020000UL,
+        0x0809000001000000UL, 0x2809000001000000UL, 0x0809000001020000UL, 0x2809000001020000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000002000000UL, 0x0000000000040000UL, 0x0000000002040000UL,
+        0x0010000000000000UL, 0x0010000002000000UL, 0x0010000000040000UL, 0x0010000002040000UL,
+        0x0000000000000000UL, 0x0000000002000000UL, 0x0000000000040000UL, 0x0000000002040000UL,
+        0x0010000000000000UL, 0x0010000002000000UL, 0x0010000000040000UL, 0x0010000002040000UL,
+        0x1000000000000000UL, 0x1000000002000000UL, 0x1000000000040000UL, 0x1000000002040000UL,
+        0x1010000000000000UL, 0x1010000002000000UL, 0x1010000000040000UL, 0x1010000002040000UL,
+        0x1000000000000000UL, 0x1000000002000000UL, 0x1000000000040000UL, 0x1000000002040000UL,
+        0x1010000000000000UL, 0x1010000002000000UL, 0x1010000000040000UL, 0x1010000002040000UL,
+        0x0000000000200000UL, 0x0000000002200000UL, 0x0000000000240000UL, 0x0000000002240000UL,
+        0x0010000000200000UL, 0x0010000002200000UL, 0x0010000000240000UL, 0x0010000002240000UL,
+        0x0000000000200000UL, 0x0000000002200000UL, 0x0000000000240000UL, 0x0000000002240000UL,
+        0x0010000000200000UL, 0x0010000002200000UL, 0x0010000000240000UL, 0x0010000002240000UL,
+        0x1000000000200000UL, 0x1000000002200000UL, 0x1000000000240000UL, 0x1000000002240000UL,
+        0x1010000000200000UL, 0x1010000002200000UL, 0x1010000000240000UL, 0x1010000002240000UL,
+        0x1000000000200000UL, 0x1000000002200000UL, 0x1000000000240000UL, 0x1000000002240000UL,
+        0x1010000000200000UL, 0x1010000002200000UL, 0x1010000000240000UL, 0x1010000002240000UL,
+        0x0000000008000000UL, 0x000000000A000000UL, 0x0000000008040000UL, 0x000000000A040000UL,
+        0x0010000008000000UL, 0x001000000A000000UL, 0x0010000008040000UL, 0x001000000A040000UL,
+        0x0000000008000000UL, 0x000000000A000000UL, 0x0000000008040000UL, 0x000000000A040000UL,
+        0x0010000008000000UL, 0x001000000A000000UL, 0x0010000008040000UL, 0x001000000A040000UL,
+        0x1000000008000000UL, 0x100000000A000000UL, 0x1000000008040000UL, 0x100000000A040000UL,
+        0x1010000008000000UL, 0x101000000A000000UL, 0x1010000008040000UL, 0x101000000A040000UL,
+        0x1000000008000000UL, 0x100000000A000000UL, 0x1000000008040000UL, 0x100000000A040000UL,
+        0x1010000008000000UL, 0x101000000A000000UL, 0x1010000008040000UL, 0x101000000A040000UL,
+        0x0000000008200000UL, 0x000000000A200000UL, 0x0000000008240000UL, 0x000000000A240000UL,
+        0x0010000008200000UL, 0x001000000A200000UL, 0x0010000008240000UL, 0x001000000A240000UL,
+        0x0000000008200000UL, 0x000000000A200000UL, 0x0000000008240000UL, 0x000000000A240000UL,
+        0x0010000008200000UL, 0x001000000A200000UL, 0x0010000008240000UL, 0x001000000A240000UL,
+        0x1000000008200000UL, 0x100000000A200000UL, 0x1000000008240000UL, 0x100000000A240000UL,
+        0x1010000008200000UL, 0x101000000A200000UL, 0x1010000008240000UL, 0x101000000A240000UL,
+        0x1000000008200000UL, 0x100000000A200000UL, 0x1000000008240000UL, 0x100000000A240000UL,
+        0x1010000008200000UL, 0x101000000A200000UL, 0x1010000008240000UL, 0x101000000A240000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000010000000UL, 0x0000000000080000UL, 0x0000000010080000UL,
+        0x0002000000000000UL, 0x0002000010000000UL, 0x0002000000080000UL, 0x0002000010080000UL,
+        0x0000000000000000UL, 0x0000000010000000UL, 0x0000000000080000UL, 0x0000000010080000UL,
+        0x0002000000000000UL, 0x0002000010000000UL, 0x0002000000080000UL, 0x0002000010080000UL,
+        0x0400000000000000UL, 0x0400000010000000UL, 0x0400000000080000UL, 0x0400000010080000UL,
+        0x0402000000000000UL, 0x0402000010000000UL, 0x0402000000080000UL, 0x0402000010080000UL,
+        0x0400000000000000UL, 0x0400000010000000UL, 0x0400000000080000UL, 0x0400000010080000UL,
+        0x0402000000000000UL, 0x0402000010000000UL, 0x0402000000080000UL, 0x0402000010080000UL,
+        0x0020000000000000UL, 0x0020000010000000UL, 0x0020000000080000UL, 0x0020000010080000UL,
+        0x0022000000000000UL, 0x0022000010000000UL, 0x0022000000080000UL, 0x0022000010080000UL,
+        0x0020000000000000UL, 0x0020000010000000UL, 0x0020000000080000UL, 0x0020000010080000UL,
+        0x0022000000000000UL, 0x0022000010000000UL, 0x0022000000080000UL, 0x0022000010080000UL,
+        0x0420000000000000UL, 0x0420000010000000UL, 0x0420000000080000UL, 0x0420000010080000UL,
+        0x0422000000000000UL, 0x0422000010000000UL, 0x0422000000080000UL, 0x0422000010080000UL,
+        0x0420000000000000UL, 0x0420000010000000UL, 0x0420000000080000UL, 0x0420000010080000UL,
+        0x0422000000000000UL, 0x0422000010000000UL, 0x0422000000080000UL, 0x0422000010080000UL,
+        0x0000000000000000UL, 0x0000000010000000UL, 0x0000000000080000UL, 0x0000000010080000UL,
+        0x0002000000000000UL, 0x0002000010000000UL, 0x0002000000080000UL, 0x0002000010080000UL,
+        0x0000000000000000UL, 0x0000000010000000UL, 0x0000000000080000UL, 0x0000000010080000UL,
+        0x0002000000000000UL, 0x0002000010000000UL, 0x0002000000080000UL, 0x0002000010080000UL,
+        0x0400000000000000UL, 0x0400000010000000UL, 0x0400000000080000UL, 0x0400000010080000UL,
+        0x0402000000000000UL, 0x0402000010000000UL, 0x0402000000080000UL, 0x0402000010080000UL,
+        0x0400000000000000UL, 0x0400000010000000UL, 0x0400000000080000UL, 0x0400000010080000UL,
+        0x0402000000000000UL, 0x0402000010000000UL, 0x0402000000080000UL, 0x0402000010080000UL,
+        0x0020000000000000UL, 0x0020000010000000UL, 0x0020000000080000UL, 0x0020000010080000UL,
+        0x0022000000000000UL, 0x0022000010000000UL, 0x0022000000080000UL, 0x0022000010080000UL,
+        0x0020000000000000UL, 0x0020000010000000UL, 0x0020000000080000UL, 0x0020000010080000UL,
+        0x0022000000000000UL, 0x0022000010000000UL, 0x0022000000080000UL, 0x0022000010080000UL,
+        0x0420000000000000UL, 0x0420000010000000UL, 0x0420000000080000UL, 0x0420000010080000UL,
+        0x0422000000000000UL, 0x0422000010000000UL, 0x0422000000080000UL, 0x0422000010080000UL,
+        0x0420000000000000UL, 0x0420000010000000UL, 0x0420000000080000UL, 0x0420000010080000UL,
+        0x0422000000000000UL, 0x0422000010000000UL, 0x0422000000080000UL, 0x0422000010080000UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000000UL, 0x0000000200000000UL, 0x0000000200000000UL,
+        0x0000000000000200UL, 0x0000000000000200UL, 0x0000000200000200UL, 0x0000000200000200UL,
+        0x0000000000000001UL, 0x0000000000000001UL, 0x0000000200000001UL, 0x0000000200000001UL,
+        0x0000000000000201UL, 0x0000000000000201UL, 0x0000000200000201UL, 0x0000000200000201UL,
+        0x0000080000000000UL, 0x0000080000000000UL, 0x0000080200000000UL, 0x0000080200000000UL,
+        0x0000080000000200UL, 0x0000080000000200UL, 0x0000080200000200UL, 0x0000080200000200UL,
+        0x0000080000000001UL, 0x0000080000000001UL, 0x0000080200000001UL, 0x0000080200000001UL,
+        0x0000080000000201UL, 0x0000080000000201UL, 0x0000080200000201UL, 0x0000080200000201UL,
+        0x0000000000002000UL, 0x0000000000002000UL, 0x0000000200002000UL, 0x0000000200002000UL,
+        0x0000000000002200UL, 0x0000000000002200UL, 0x0000000200002200UL, 0x0000000200002200UL,
+        0x0000000000002001UL, 0x0000000000002001UL, 0x0000000200002001UL, 0x0000000200002001UL,
+        0x0000000000002201UL, 0x0000000000002201UL, 0x0000000200002201UL, 0x0000000200002201UL,
+        0x0000080000002000UL, 0x0000080000002000UL, 0x0000080200002000UL, 0x0000080200002000UL,
+        0x0000080000002200UL, 0x0000080000002200UL, 0x0000080200002200UL, 0x0000080200002200UL,
+        0x0000080000002001UL, 0x0000080000002001UL, 0x0000080200002001UL, 0x0000080200002001UL,
+        0x0000080000002201UL, 0x0000080000002201UL, 0x0000080200002201UL, 0x0000080200002201UL,
+        0x0000000000000002UL, 0x0000000000000002UL, 0x0000000200000002UL, 0x0000000200000002UL,
+        0x0000000000000202UL, 0x0000000000000202UL, 0x0000000200000202UL, 0x0000000200000202UL,
+        0x0000000000000003UL, 0x0000000000000003UL, 0x0000000200000003UL, 0x0000000200000003UL,
+        0x0000000000000203UL, 0x0000000000000203UL, 0x0000000200000203UL, 0x0000000200000203UL,
+        0x0000080000000002UL, 0x0000080000000002UL, 0x0000080200000002UL, 0x0000080200000002UL,
+        0x0000080000000202UL, 0x0000080000000202UL, 0x0000080200000202UL, 0x0000080200000202UL,
+        0x0000080000000003UL, 0x0000080000000003UL, 0x0000080200000003UL, 0x0000080200000003UL,
+        0x0000080000000203UL, 0x0000080000000203UL, 0x0000080200000203UL, 0x0000080200000203UL,
+        0x0000000000002002UL, 0x0000000000002002UL, 0x0000000200002002UL, 0x0000000200002002UL,
+        0x0000000000002202UL, 0x0000000000002202UL, 0x0000000200002202UL, 0x0000000200002202UL,
+        0x0000000000002003UL, 0x0000000000002003UL, 0x0000000200002003UL, 0x0000000200002003UL,
+        0x0000000000002203UL, 0x0000000000002203UL, 0x0000000200002203UL, 0x0000000200002203UL,
+        0x0000080000002002UL, 0x0000080000002002UL, 0x0000080200002002UL, 0x0000080200002002UL,
+        0x0000080000002202UL, 0x0000080000002202UL, 0x0000080200002202UL, 0x0000080200002202UL,
+        0x0000080000002003UL, 0x0000080000002003UL, 0x0000080200002003UL, 0x0000080200002003UL,
+        0x0000080000002203UL, 0x0000080000002203UL, 0x0000080200002203UL, 0x0000080200002203UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000000000010UL, 0x0000200000000000UL, 0x0000200000000010UL,
+        0x0000000000001000UL, 0x0000000000001010UL, 0x0000200000001000UL, 0x0000200000001010UL,
+        0x0000000800000000UL, 0x0000000800000010UL, 0x0000200800000000UL, 0x0000200800000010UL,
+        0x0000000800001000UL, 0x0000000800001010UL, 0x0000200800001000UL, 0x0000200800001010UL,
+        0x0000000000000000UL, 0x0000000000000010UL, 0x0000200000000000UL, 0x0000200000000010UL,
+        0x0000000000001000UL, 0x0000000000001010UL, 0x0000200000001000UL, 0x0000200000001010UL,
+        0x0000000800000000UL, 0x0000000800000010UL, 0x0000200800000000UL, 0x0000200800000010UL,
+        0x0000000800001000UL, 0x0000000800001010UL, 0x0000200800001000UL, 0x0000200800001010UL,
+        0x0000040000000000UL, 0x0000040000000010UL, 0x0000240000000000UL, 0x0000240000000010UL,
+        0x0000040000001000UL, 0x0000040000001010UL, 0x0000240000001000UL, 0x0000240000001010UL,
+        0x0000040800000000UL, 0x0000040800000010UL, 0x0000240800000000UL, 0x0000240800000010UL,
+        0x0000040800001000UL, 0x0000040800001010UL, 0x0000240800001000UL, 0x0000240800001010UL,
+        0x0000040000000000UL, 0x0000040000000010UL, 0x0000240000000000UL, 0x0000240000000010UL,
+        0x0000040000001000UL, 0x0000040000001010UL, 0x0000240000001000UL, 0x0000240000001010UL,
+        0x0000040800000000UL, 0x0000040800000010UL, 0x0000240800000000UL, 0x0000240800000010UL,
+        0x0000040800001000UL, 0x0000040800001010UL, 0x0000240800001000UL, 0x0000240800001010UL,
+        0x0000000000000004UL, 0x0000000000000014UL, 0x0000200000000004UL, 0x0000200000000014UL,
+        0x0000000000001004UL, 0x0000000000001014UL, 0x0000200000001004UL, 0x0000200000001014UL,
+        0x0000000800000004UL, 0x0000000800000014UL, 0x0000200800000004UL, 0x0000200800000014UL,
+        0x0000000800001004UL, 0x0000000800001014UL, 0x0000200800001004UL, 0x0000200800001014UL,
+        0x0000000000000004UL, 0x0000000000000014UL, 0x0000200000000004UL, 0x0000200000000014UL,
+        0x0000000000001004UL, 0x0000000000001014UL, 0x0000200000001004UL, 0x0000200000001014UL,
+        0x0000000800000004UL, 0x0000000800000014UL, 0x0000200800000004UL, 0x0000200800000014UL,
+        0x0000000800001004UL, 0x0000000800001014UL, 0x0000200800001004UL, 0x0000200800001014UL,
+        0x0000040000000004UL, 0x0000040000000014UL, 0x0000240000000004UL, 0x0000240000000014UL,
+        0x0000040000001004UL, 0x0000040000001014UL, 0x0000240000001004UL, 0x0000240000001014UL,
+        0x0000040800000004UL, 0x0000040800000014UL, 0x0000240800000004UL, 0x0000240800000014UL,
+        0x0000040800001004UL, 0x0000040800001014UL, 0x0000240800001004UL, 0x0000240800001014UL,
+        0x0000040000000004UL, 0x0000040000000014UL, 0x0000240000000004UL, 0x0000240000000014UL,
+        0x0000040000001004UL, 0x0000040000001014UL, 0x0000240000001004UL, 0x0000240000001014UL,
+        0x0000040800000004UL, 0x0000040800000014UL, 0x0000240800000004UL, 0x0000240800000014UL,
+        0x0000040800001004UL, 0x0000040800001014UL, 0x0000240800001004UL, 0x0000240800001014UL
+    },
+    {
+        0x0000000000000000UL, 0x0000001000000000UL, 0x0000000000000100UL, 0x0000001000000100UL,
+        0x0000020000000000UL, 0x0000021000000000UL, 0x0000020000000100UL, 0x0000021000000100UL,
+        0x0000000000000020UL, 0x0000001000000020UL, 0x0000000000000120UL, 0x0000001000000120UL,
+        0x0000020000000020UL, 0x0000021000000020UL, 0x0000020000000120UL, 0x0000021000000120UL,
+        0x0000000000000400UL, 0x0000001000000400UL, 0x0000000000000500UL, 0x0000001000000500UL,
+        0x0000020000000400UL, 0x0000021000000400UL, 0x0000020000000500UL, 0x0000021000000500UL,
+        0x0000000000000420UL, 0x0000001000000420UL, 0x0000000000000520UL, 0x0000001000000520UL,
+        0x0000020000000420UL, 0x0000021000000420UL, 0x0000020000000520UL, 0x0000021000000520UL,
+        0x0000002000000000UL, 0x0000003000000000UL, 0x0000002000000100UL, 0x0000003000000100UL,
+        0x0000022000000000UL, 0x0000023000000000UL, 0x0000022000000100UL, 0x0000023000000100UL,
+        0x0000002000000020UL, 0x0000003000000020UL, 0x0000002000000120UL, 0x0000003000000120UL,
+        0x0000022000000020UL, 0x0000023000000020UL, 0x0000022000000120UL, 0x0000023000000120UL,
+        0x0000002000000400UL, 0x0000003000000400UL, 0x0000002000000500UL, 0x0000003000000500UL,
+        0x0000022000000400UL, 0x0000023000000400UL, 0x0000022000000500UL, 0x0000023000000500UL,
+        0x0000002000000420UL, 0x0000003000000420UL, 0x0000002000000520UL, 0x0000003000000520UL,
+        0x0000022000000420UL, 0x0000023000000420UL, 0x0000022000000520UL, 0x0000023000000520UL,
+        0x0000000000000000UL, 0x0000001000000000UL, 0x0000000000000100UL, 0x0000001000000100UL,
+        0x0000020000000000UL, 0x0000021000000000UL, 0x0000020000000100UL, 0x0000021000000100UL,
+        0x0000000000000020UL, 0x0000001000000020UL, 0x0000000000000120UL, 0x0000001000000120UL,
+        0x0000020000000020UL, 0x0000021000000020UL, 0x0000020000000120UL, 0x0000021000000120UL,
+        0x0000000000000400UL, 0x0000001000000400UL, 0x0000000000000500UL, 0x0000001000000500UL,
+        0x0000020000000400UL, 0x0000021000000400UL, 0x0000020000000500UL, 0x0000021000000500UL,
+        0x0000000000000420UL, 0x0000001000000420UL, 0x0000000000000520UL, 0x0000001000000520UL,
+        0x0000020000000420UL, 0x0000021000000420UL, 0x0000020000000520UL, 0x0000021000000520UL,
+        0x0000002000000000UL, 0x0000003000000000UL, 0x0000002000000100UL, 0x0000003000000100UL,
+        0x0000022000000000UL, 0x0000023000000000UL, 0x0000022000000100UL, 0x0000023000000100UL,
+        0x0000002000000020UL, 0x0000003000000020UL, 0x0000002000000120UL, 0x0000003000000120UL,
+        0x0000022000000020UL, 0x0000023000000020UL, 0x0000022000000120UL, 0x0000023000000120UL,
+        0x0000002000000400UL, 0x0000003000000400UL, 0x0000002000000500UL, 0x0000003000000500UL,
+        0x0000022000000400UL, 0x0000023000000400UL, 0x0000022000000500UL, 0x0000023000000500UL,
+        0x0000002000000420UL, 0x0000003000000420UL, 0x0000002000000520UL, 0x0000003000000520UL,
+        0x0000022000000420UL, 0x0000023000000420UL, 0x0000022000000520UL, 0x0000023000000520UL
+    },
+    {
+        0x0000000000000000UL, 0x0000000400000000UL, 0x0000010000000000UL, 0x0000010400000000UL,
+        0x0000000000000000UL, 0x0000000400000000UL, 0x0000010000000000UL, 0x0000010400000000UL,
+        0x0000000100000000UL, 0x0000000500000000UL, 0x0000010100000000UL, 0x0000010500000000UL,
+        0x0000000100000000UL, 0x0000000500000000UL, 0x0000010100000000UL, 0x0000010500000000UL,
+        0x0000100000000000UL, 0x0000100400000000UL, 0x0000110000000000UL, 0x0000110400000000UL,
+        0x0000100000000000UL, 0x0000100400000000UL, 0x0000110000000000UL, 0x0000110400000000UL,
+        0x0000100100000000UL, 0x0000100500000000UL, 0x0000110100000000UL, 0x0000110500000000UL,
+        0x0000100100000000UL, 0x0000100500000000UL, 0x0000110100000000UL, 0x0000110500000000UL,
+        0x0000000000000800UL, 0x0000000400000800UL, 0x0000010000000800UL, 0x0000010400000800UL,
+        0x0000000000000800UL, 0x0000000400000800UL, 0x0000010000000800UL, 0x0000010400000800UL,
+        0x0000000100000800UL, 0x0000000500000800UL, 0x0000010100000800UL, 0x0000010500000800UL,
+        0x0000000100000800UL, 0x0000000500000800UL, 0x0000010100000800UL, 0x0000010500000800UL,
+        0x0000100000000800UL, 0x0000100400000800UL, 0x0000110000000800UL, 0x0000110400000800UL,
+        0x0000100000000800UL, 0x0000100400000800UL, 0x0000110000000800UL, 0x0000110400000800UL,
+        0x0000100100000800UL, 0x0000100500000800UL, 0x0000110100000800UL, 0x0000110500000800UL,
+        0x0000100100000800UL, 0x0000100500000800UL, 0x0000110100000800UL, 0x0000110500000800UL,
+        0x0000000000000008UL, 0x0000000400000008UL, 0x0000010000000008UL, 0x0000010400000008UL,
+        0x0000000000000008UL, 0x0000000400000008UL, 0x0000010000000008UL, 0x0000010400000008UL,
+        0x0000000100000008UL, 0x0000000500000008UL, 0x0000010100000008UL, 0x0000010500000008UL,
+        0x0000000100000008UL, 0x0000000500000008UL, 0x0000010100000008UL, 0x0000010500000008UL,
+        0x0000100000000008UL, 0x0000100400000008UL, 0x0000110000000008UL, 0x0000110400000008UL,
+        0x0000100000000008UL, 0x0000100400000008UL, 0x0000110000000008UL, 0x0000110400000008UL,
+        0x0000100100000008UL, 0x0000100500000008UL, 0x0000110100000008UL, 0x0000110500000008UL,
+        0x0000100100000008UL, 0x0000100500000008UL, 0x0000110100000008UL, 0x0000110500000008UL,
+        0x0000000000000808UL, 0x0000000400000808UL, 0x0000010000000808UL, 0x0000010400000808UL,
+        0x0000000000000808UL, 0x0000000400000808UL, 0x0000010000000808UL, 0x0000010400000808UL,
+        0x0000000100000808UL, 0x0000000500000808UL, 0x0000010100000808UL, 0x0000010500000808UL,
+        0x0000000100000808UL, 0x0000000500000808UL, 0x0000010100000808UL, 0x0000010500000808UL,
+        0x0000100000000808UL, 0x0000100400000808UL, 0x0000110000000808UL, 0x0000110400000808UL,
+        0x0000100000000808UL, 0x0000100400000808UL, 0x0000110000000808UL, 0x0000110400000808UL,
+        0x0000100100000808UL, 0x0000100500000808UL, 0x0000110100000808UL, 0x0000110500000808UL,
+        0x0000100100000808UL, 0x0000100500000808UL, 0x0000110100000808UL, 0x0000110500000808UL
+    }
+};
+#pragma acc declare copyin(_PC1, _PC2)
+
+/* PC1 of the key a nibble at a time, by lookups in _PC1. Returns C << 28 | D */
+static unsigned long _despc1(unsigned char *key)
+{
+    unsigned long cd = 0UL;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        cd |= _PC1[i << 1][key[i] >> 4] | _PC1[(i << 1) + 1][key[i] & 0xf];
+
+    return cd;
+}
+
+/* PC2 and _cookey() of (already rotated) C and D seven bits at a time.
+   Returns the two cooked subkeys of the round as KnL[2i] << 32 | KnL[2i + 1] */
+static unsigned long _despc2(unsigned long c, unsigned long d)
+{
+    unsigned long pair;
+
+    pair  = _PC2[0][ c >> 21        ];
+    pair |= _PC2[1][(c >> 14) & 0x7f];
+    pair |= _PC2[2][(c >>  7) & 0x7f];
+    pair |= _PC2[3][ c        & 0x7f];
+    pair |= _PC2[4][ d >> 21        ];
+    pair |= _PC2[5][(d >> 14) & 0x7f];
+    pair |= _PC2[6][(d >>  7) & 0x7f];
+    pair |= _PC2[7][ d        & 0x7f];
+
+    return pair;
+}
+
+/* Same as _deskn(), but with _despc1() and _despc2(). C and D are rotated in place */
+static void _desknfast(desprng_common_t *process_data, unsigned char *key, unsigned long *cook)
+{
+    unsigned long cd, c, d, pair;
+    int i, shift;
+
+    cd = _despc1(key);
+    c = cd >> 28;
+    d = cd & 0xfffffffL;
+    for (i = 0; i < 16; i++)
+    {
+        shift = process_data->totrot[i] - (i ? process_data->totrot[i - 1] : 0);
+        c = ((c << shift) | (c >> (28 - shift))) & 0xfffffffL;
+        d = ((d << shift) | (d >> (28 - shift))) & 0xfffffffL;
+        pair = _despc2(c, d);
+        *cook++ = pair >> 32;
+        *cook++ = pair & 0xffffffffL;
+    }
+
+    return;
+}
+
+static void _cookey(unsigned long *raw1, unsigned long *cook)
+{
+    unsigned long *raw0;
     int i;
 
-    cook = dough;
     for (i = 0; i < 16; i++, raw1++)
     {
         raw0 = raw1++;
@@ -93,7 +607,6 @@ static void _cookey(desprng_individual_t *thread_data, unsigned long *raw1)
         *cook   |= (*raw1 & 0x0003f000L) >> 4;
         *cook++ |= (*raw1 & 0x0000003fL);
     }
-    _usekey(thread_data, dough);
 
     return;
 }
@@ -120,7 +633,170 @@ void _des(desprng_common_t *process_data, desprng_individual_t *thread_data, uns
     return;
 }
 
-static void _scrunch(unsigned char *outof, unsigned long *into)
+/* Same as _des(), but with the block as an unsigned long (in the byte order of
+   the host, as make_prn() passes it), which saves the byte-wise _scrunch() and
+   _unscrun() */
+#pragma acc routine seq
+unsigned long _desword(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long inword)
+{
+    unsigned long work[2];
+
+    _wordin(inword, work);
+    _desfunc(process_data, work, thread_data->KnL);
+
+    return _wordout(work);
+}
+
+/* Version 1 of the PRNG-only variant (np1), which is DES without the initial
+   and final permutations. The block is taken straight from the value of
+   inword, the high 32 bits as the left half and the low 32 bits as the right
+   half (in the rotated form that _desf() works on), and the PRN is the right
+   half after the 16 rounds in the high 32 bits and the left half in the low
+   32 bits. This does not depend on the byte order. Its output is different
+   from that of make_prn(), and must not change: a new variant gets a new name */
+#pragma acc routine seq
+unsigned long _deswordnp1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long inword)
+{
+    unsigned long right, leftt, *keys = thread_data->KnL;
+    int round;
+
+    leftt = inword >> 32;
+    right = inword & 0xffffffffUL;
+    for (round = 0; round < 8; round++)
+    {
+        leftt ^= _desf(process_data, right, keys[0], keys[1]);
+        keys += 2;
+        right ^= _desf(process_data, leftt, keys[0], keys[1]);
+        keys += 2;
+    }
+
+    return (right << 32) | leftt;
+}
+
+/* Same as _desword(), but with only the first rounds (an even number up to
+   16) of the 16 DES rounds, for the reduced-round PRN tiers */
+#pragma acc routine seq
+unsigned long _desrounds(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long inword, int rounds)
+{
+    unsigned long work[2];
+
+    _wordin(inword, work);
+    _desfuncr(process_data, work, thread_data->KnL, rounds);
+
+    return _wordout(work);
+}
+
+/* Same as _des(), but for the compact state with 32-bit subkeys */
+#pragma acc routine seq
+void _des32(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned char *inblock, unsigned char *outblock)
+{
+    unsigned long work[2];
+
+    _scrunch(inblock, work);
+    _desfunc32(process_data, work, compact_data->KnL);
+    _unscrun(work, outblock);
+
+    return;
+}
+
+/* Same as _des32(), but with the 32-bit SP arrays of desprng_table_t */
+#pragma acc routine seq
+void _destab(desprng_table_t *table_data, desprng_compact_t *compact_data, unsigned char *inblock, unsigned char *outblock)
+{
+    unsigned long work[2];
+
+    _scrunch(inblock, work);
+    _desfunctab(table_data, work, compact_data->KnL);
+    _unscrun(work, outblock);
+
+    return;
+}
+
+/* Same as _des32(), but with the paired SP arrays of desprng_pairtable_t */
+#pragma acc routine seq
+void _despair(desprng_pairtable_t *pairtable_data, desprng_compact_t *compact_data, unsigned char *inblock, unsigned char *outblock)
+{
+    unsigned long work[2];
+
+    _scrunch(inblock, work);
+    _desfuncpair(pairtable_data, work, compact_data->KnL);
+    _unscrun(work, outblock);
+
+    return;
+}
+
+/* Same as _des(), but with the subkeys derived on the fly from the identifier
+   in key, so that no expanded key schedule is stored. C and D are rotated
+   round by round, and each pair of subkeys is used as soon as it is made */
+#pragma acc routine seq
+void _desident(desprng_common_t *process_data, unsigned char *key, unsigned char *inblock, unsigned char *outblock)
+{
+    unsigned long work[2], right, leftt, cd, c, d, pair;
+    int i, shift;
+
+    cd = _despc1(key);
+    c = cd >> 28;
+    d = cd & 0xfffffffL;
+
+    _scrunch(inblock, work);
+    _desip(work);
+    leftt = work[0];
+    right = work[1];
+    for (i = 0; i < 16; i++)
+    {
+        shift = process_data->totrot[i] - (i ? process_data->totrot[i - 1] : 0);
+        c = ((c << shift) | (c >> (28 - shift))) & 0xfffffffL;
+        d = ((d << shift) | (d >> (28 - shift))) & 0xfffffffL;
+        pair = _despc2(c, d);
+        if (i & 1)
+            right ^= _desf(process_data, leftt, pair >> 32, pair & 0xffffffffL);
+        else
+            leftt ^= _desf(process_data, right, pair >> 32, pair & 0xffffffffL);
+    }
+    work[0] = leftt;
+    work[1] = right;
+    _desfp(work);
+    _unscrun(work, outblock);
+
+    return;
+}
+
+/* Encrypts the n consecutive counters icount, icount + 1, ... into iprn,
+   interleaving DES_INTERLEAVE independent blocks to hide the latency of the SP
+   lookups. The subkeys are shared by all blocks */
+#pragma acc routine seq
+void _desrange(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long n, unsigned long *iprn)
+{
+    unsigned long block[DES_INTERLEAVE][2], *keys, i;
+    int k, round;
+
+    for (i = 0UL; i < n; i += DES_INTERLEAVE)
+    {
+        for (k = 0; k < DES_INTERLEAVE; k++)
+        {
+            _wordin(icount + i + k, block[k]);
+            _desip(block[k]);
+        }
+        keys = thread_data->KnL;
+        for (round = 0; round < 8; round++)
+        {
+            for (k = 0; k < DES_INTERLEAVE; k++) block[k][0] ^= _desf(process_data, block[k][1], keys[0], keys[1]);
+            keys += 2;
+            for (k = 0; k < DES_INTERLEAVE; k++) block[k][1] ^= _desf(process_data, block[k][0], keys[0], keys[1]);
+            keys += 2;
+        }
+        /* The blocks beyond the end of the range are thrown away */
+        for (k = 0; k < DES_INTERLEAVE && i + k < n; k++)
+        {
+            _desfp(block[k]);
+            iprn[i + k] = _wordout(block[k]);
+        }
+    }
+
+    return;
+}
+
+void _scrunch(unsigned char *outof, unsigned long *into)
 {
     *into    = (*outof++ & 0xffL) << 24;
     *into   |= (*outof++ & 0xffL) << 16;
@@ -134,7 +810,7 @@ static void _scrunch(unsigned char *outof, unsigned long *into)
     return;
 }
 
-static void _unscrun(unsigned long *outof, unsigned char *into)
+void _unscrun(unsigned long *outof, unsigned char *into)
 {
     *into++ = (*outof >> 24) & 0xffL;
     *into++ = (*outof >> 16) & 0xffL;
@@ -148,11 +824,49 @@ static void _unscrun(unsigned long *outof, unsigned char *into)
     return;
 }
 
-static void _desfunc(desprng_common_t *process_data, unsigned long *block, unsigned long *keys)
+/* Reverses the byte order of a word, with bswap where the compiler has it */
+static unsigned long _desswap(unsigned long word)
 {
-    unsigned long fval, work, right, leftt;
-    int round;
-    
+#if defined(__GNUC__) && !defined(_OPENACC)
+    return __builtin_bswap64(word);
+#else
+    word = ((word & 0x00ff00ff00ff00ffUL) << 8) | ((word >> 8) & 0x00ff00ff00ff00ffUL);
+    word = ((word & 0x0000ffff0000ffffUL) << 16) | ((word >> 16) & 0x0000ffff0000ffffUL);
+
+    return (word << 32) | (word >> 32);
+#endif
+}
+
+/* Same as _scrunch() of the bytes of word, i.e. the first four bytes in memory
+   make block[0] and the last four block[1], most significant first */
+static void _wordin(unsigned long word, unsigned long *block)
+{
+#ifndef DES_BIG_ENDIAN
+    word = _desswap(word);
+#endif
+    block[0] = word >> 32;
+    block[1] = word & 0xffffffffUL;
+
+    return;
+}
+
+/* Same as _unscrun() into the bytes of the returned word */
+static unsigned long _wordout(unsigned long *block)
+{
+    unsigned long word = (block[0] << 32) | (block[1] & 0xffffffffUL);
+
+#ifndef DES_BIG_ENDIAN
+    word = _desswap(word);
+#endif
+
+    return word;
+}
+
+/* Initial permutation, which leaves the left and right halves in block[0] and block[1] */
+void _desip(unsigned long *block)
+{
+    unsigned long work, right, leftt;
+
     leftt = block[0];
     right = block[1];
     work = ((leftt >> 4) ^ right) & 0x0f0f0f0fL;
@@ -172,34 +886,19 @@ static void _desfunc(desprng_common_t *process_data, unsigned long *block, unsig
     leftt ^= work;
     right ^= work;
     leftt = ((leftt << 1) | ((leftt >> 31) & 1L)) & 0xffffffffL;
-    
-    for (round = 0; round < 8; round++)
-    {
-        work  = (right << 28) | (right >> 4);
-        work ^= *keys++;
-        fval  = process_data->SP[6][ work        & 0x3fL];
-        fval |= process_data->SP[4][(work >>  8) & 0x3fL];
-        fval |= process_data->SP[2][(work >> 16) & 0x3fL];
-        fval |= process_data->SP[0][(work >> 24) & 0x3fL];
-        work  = right ^ *keys++;
-        fval |= process_data->SP[7][ work        & 0x3fL];
-        fval |= process_data->SP[5][(work >>  8) & 0x3fL];
-        fval |= process_data->SP[3][(work >> 16) & 0x3fL];
-        fval |= process_data->SP[1][(work >> 24) & 0x3fL];
-        leftt ^= fval;
-        work  = (leftt << 28) | (leftt >> 4);
-        work ^= *keys++;
-        fval  = process_data->SP[6][ work        & 0x3fL];
-        fval |= process_data->SP[4][(work >>  8) & 0x3fL];
-        fval |= process_data->SP[2][(work >> 16) & 0x3fL];
-        fval |= process_data->SP[0][(work >> 24) & 0x3fL];
-        work  = leftt ^ *keys++;
-        fval |= process_data->SP[7][ work        & 0x3fL];
-        fval |= process_data->SP[5][(work >>  8) & 0x3fL];
-        fval |= process_data->SP[3][(work >> 16) & 0x3fL];
-        fval |= process_data->SP[1][(work >> 24) & 0x3fL];
-        right ^= fval;
-    }
+    block[0] = leftt;
+    block[1] = right;
+
+    return;
+}
+
+/* Final permutation of the left and right halves in block[0] and block[1] */
+void _desfp(unsigned long *block)
+{
+    unsigned long work, right, leftt;
+
+    leftt = block[0];
+    right = block[1];
     right = (right << 31) | (right >> 1);
     work = (leftt ^ right) & 0xaaaaaaaaL;
     leftt ^= work;
@@ -222,3 +921,161 @@ static void _desfunc(desprng_common_t *process_data, unsigned long *block, unsig
 
     return;
 }
+
+/* The cipher function f of one DES round, using the two subkeys key0 and key1 */
+static unsigned long _desf(desprng_common_t *process_data, unsigned long right, unsigned long key0, unsigned long key1)
+{
+    unsigned long fval, work;
+
+    work  = (right << 28) | (right >> 4);
+    work ^= key0;
+    fval  = process_data->SP[6][ work        & 0x3fL];
+    fval |= process_data->SP[4][(work >>  8) & 0x3fL];
+    fval |= process_data->SP[2][(work >> 16) & 0x3fL];
+    fval |= process_data->SP[0][(work >> 24) & 0x3fL];
+    work  = right ^ key1;
+    fval |= process_data->SP[7][ work        & 0x3fL];
+    fval |= process_data->SP[5][(work >>  8) & 0x3fL];
+    fval |= process_data->SP[3][(work >> 16) & 0x3fL];
+    fval |= process_data->SP[1][(work >> 24) & 0x3fL];
+
+    return fval;
+}
+
+static void _desfunc(desprng_common_t *process_data, unsigned long *block, unsigned long *keys)
+{
+    _desfuncr(process_data, block, keys, 16);
+
+    return;
+}
+
+/* Same as _desfunc(), but with the number of rounds (even, up to 16) as an argument */
+static void _desfuncr(desprng_common_t *process_data, unsigned long *block, unsigned long *keys, int rounds)
+{
+    unsigned long right, leftt;
+    int round;
+
+    _desip(block);
+    leftt = block[0];
+    right = block[1];
+
+    for (round = 0; round < rounds; round += 2)
+    {
+        leftt ^= _desf(process_data, right, keys[0], keys[1]);
+        keys += 2;
+        right ^= _desf(process_data, leftt, keys[0], keys[1]);
+        keys += 2;
+    }
+    block[0] = leftt;
+    block[1] = right;
+    _desfp(block);
+
+    return;
+}
+
+static void _desfunc32(desprng_common_t *process_data, unsigned long *block, unsigned *keys)
+{
+    unsigned long right, leftt;
+    int round;
+
+    _desip(block);
+    leftt = block[0];
+    right = block[1];
+
+    for (round = 0; round < 8; round++)
+    {
+        leftt ^= _desf(process_data, right, keys[0], keys[1]);
+        keys += 2;
+        right ^= _desf(process_data, leftt, keys[0], keys[1]);
+        keys += 2;
+    }
+    block[0] = leftt;
+    block[1] = right;
+    _desfp(block);
+
+    return;
+}
+
+/* Same as _desf(), but with the 32-bit SP arrays of desprng_table_t */
+static unsigned long _desftab(desprng_table_t *table_data, unsigned long right, unsigned long key0, unsigned long key1)
+{
+    unsigned long fval, work;
+
+    work  = (right << 28) | (right >> 4);
+    work ^= key0;
+    fval  = table_data->SP[6][ work        & 0x3fL];
+    fval |= table_data->SP[4][(work >>  8) & 0x3fL];
+    fval |= table_data->SP[2][(work >> 16) & 0x3fL];
+    fval |= table_data->SP[0][(work >> 24) & 0x3fL];
+    work  = right ^ key1;
+    fval |= table_data->SP[7][ work        & 0x3fL];
+    fval |= table_data->SP[5][(work >>  8) & 0x3fL];
+    fval |= table_data->SP[3][(work >> 16) & 0x3fL];
+    fval |= table_data->SP[1][(work >> 24) & 0x3fL];
+
+    return fval;
+}
+
+static void _desfunctab(desprng_table_t *table_data, unsigned long *block, unsigned *keys)
+{
+    unsigned long right, leftt;
+    int round;
+
+    _desip(block);
+    leftt = block[0];
+    right = block[1];
+
+    for (round = 0; round < 8; round++)
+    {
+        leftt ^= _desftab(table_data, right, keys[0], keys[1]);
+        keys += 2;
+        right ^= _desftab(table_data, leftt, keys[0], keys[1]);
+        keys += 2;
+    }
+    block[0] = leftt;
+    block[1] = right;
+    _desfp(block);
+
+    return;
+}
+
+/* Same as _desf(), but with the paired SP arrays of desprng_pairtable_t. The
+   two 6-bit groups in bits 0-5 and 8-13 (and in bits 16-21 and 24-29) of work
+   make the 12-bit index of one paired table */
+static unsigned long _desfpair(desprng_pairtable_t *pairtable_data, unsigned long right, unsigned long key0, unsigned long key1)
+{
+    unsigned long fval, work;
+
+    work  = (right << 28) | (right >> 4);
+    work ^= key0;
+    fval  = pairtable_data->SP[0][( work        & 0x3fL) | ((work >>  2) & 0xfc0L)];
+    fval |= pairtable_data->SP[1][((work >> 16) & 0x3fL) | ((work >> 18) & 0xfc0L)];
+    work  = right ^ key1;
+    fval |= pairtable_data->SP[2][( work        & 0x3fL) | ((work >>  2) & 0xfc0L)];
+    fval |= pairtable_data->SP[3][((work >> 16) & 0x3fL) | ((work >> 18) & 0xfc0L)];
+
+    return fval;
+}
+
+static void _desfuncpair(desprng_pairtable_t *pairtable_data, unsigned long *block, unsigned *keys)
+{
+    unsigned long right, leftt;
+    int round;
+
+    _desip(block);
+    leftt = block[0];
+    right = block[1];
+
+    for (round = 0; round < 8; round++)
+    {
+        leftt ^= _desfpair(pairtable_data, right, keys[0], keys[1]);
+        keys += 2;
+        right ^= _desfpair(pairtable_data, leftt, keys[0], keys[1]);
+        keys += 2;
+    }
+    block[0] = leftt;
+    block[1] = right;
+    _desfp(block);
+
+    return;
+}
@@ -0,0 +1,369 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "desprng.h"
+
+/* Microbenchmarks of the libdesprng entry points, written to stdout as JSON.
+   Each entry point is timed with warm caches (every thread reuses one state)
+   and, where it reads a per-particle state, with cold caches (the states
+   are picked at random from Ncold states, about 50 MB, and a buffer larger
+   than the last-level cache is swept before the timing starts). With OpenMP,
+   every benchmark is repeated for 1, 2, 4, ... threads.
+
+   Usage: desbench [scale]
+   The number of calls per benchmark is multiplied by scale (default 1, and
+   it must be positive and below 1e6). */
+
+#define Ncold 65536UL
+#define Nflush (1UL << 26)
+#define Nbatch 512UL
+
+/* The des.c functions that are benchmarked directly */
+extern void _deskey(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key);
+extern void _deskeyfast(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key);
+extern void _des(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *inblock, unsigned char *outblock);
+
+/* What the benchmarks share */
+typedef struct bench_data
+{
+    desprng_common_t *process_data;
+    desprng_table_t *table_data;
+    desprng_pairtable_t *pairtable_data;
+    desprng_individual_t *cold;          /* Ncold states */
+    desprng_individual_t *warm;          /* One state per thread */
+    desprng_compact_t *compact;          /* One per thread */
+    desprng_compact_t *coldcompact;      /* Ncold compact states, for the same identifiers as cold */
+    unsigned long *nidents;              /* Identifiers of the cold states */
+    unsigned long *sink;                 /* One per thread, to keep the results alive */
+}
+bench_t;
+
+/* A benchmark does calls ibegin to iend - 1 on thread ithread, with warm or cold caches */
+typedef void (*kernel_t)(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend);
+
+/* Picks a cold state for call i, in an order that defeats the hardware prefetchers */
+#define COLD(i) (((i) * 40503UL) % Ncold)
+
+static void k_initialize_common(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    desprng_common_t process_data;
+    unsigned long i;
+
+    (void)cold; /* No per-particle state, so no cold variant */
+    for (i = ibegin; i < iend; i++) initialize_common(&process_data);
+    b->sink[ithread * 8] ^= process_data.SP[0][1];
+}
+
+static void k_create_identifier(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, nident;
+
+    (void)cold; /* No per-particle state, so no cold variant */
+    for (i = ibegin; i < iend; i++)
+    {
+        nident = i & 0x00ffffffffffffffUL;
+        create_identifier(&nident);
+        b->sink[ithread * 8] ^= nident;
+    }
+}
+
+static void k_initialize_individual(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i;
+
+    for (i = ibegin; i < iend; i++)
+        initialize_individual(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, b->nidents[COLD(i)]);
+}
+
+static void k_deskey(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i;
+
+    for (i = ibegin; i < iend; i++)
+        _deskey(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, (unsigned char *)(b->nidents + COLD(i)));
+}
+
+static void k_deskeyfast(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i;
+
+    for (i = ibegin; i < iend; i++)
+        _deskeyfast(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, (unsigned char *)(b->nidents + COLD(i)));
+}
+
+static void k_des(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        _des(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, (unsigned char *)&i, (unsigned char *)&iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+static void k_make_prn(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        make_prn(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, i, &iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+static void k_make_prn_np1(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        make_prn_np1(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, i, &iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+static void k_get_uniform_prn(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+    double xprn = 0.0;
+
+    for (i = ibegin; i < iend; i++)
+        xprn += get_uniform_prn(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, i, &iprn);
+    b->sink[ithread * 8] ^= (unsigned long)xprn;
+}
+
+static void k_make_prn_compact(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        make_prn_compact(b->process_data, cold ? b->coldcompact + COLD(i) : b->compact + ithread, i, &iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+static void k_make_prn_table(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        make_prn_table(b->table_data, cold ? b->coldcompact + COLD(i) : b->compact + ithread, i, &iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+static void k_make_prn_paired(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        make_prn_paired(b->pairtable_data, cold ? b->coldcompact + COLD(i) : b->compact + ithread, i, &iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+static void k_make_prn_ident(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn;
+
+    for (i = ibegin; i < iend; i++)
+    {
+        make_prn_ident(b->process_data, b->nidents[cold ? COLD(i) : (unsigned long)ithread], i, &iprn);
+        b->sink[ithread * 8] ^= iprn;
+    }
+}
+
+/* The batch backends do Nbatch PRNs per step, so ibegin and iend are multiples of Nbatch */
+static void k_make_prn_range(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, iprn[Nbatch];
+
+    for (i = ibegin; i < iend; i += Nbatch)
+    {
+        make_prn_range(b->process_data, cold ? b->cold + COLD(i) : b->warm + ithread, i, Nbatch, iprn);
+        b->sink[ithread * 8] ^= iprn[Nbatch - 1];
+    }
+}
+
+static void k_make_prn_simd(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, j, icount[Nbatch], iprn[Nbatch];
+
+    for (i = ibegin; i < iend; i += Nbatch)
+    {
+        for (j = 0UL; j < Nbatch; j++) icount[j] = i;
+        make_prn_simd(b->process_data, b->cold + (cold ? COLD(i) / Nbatch * Nbatch : ithread * Nbatch % Ncold), Nbatch, icount, iprn);
+        b->sink[ithread * 8] ^= iprn[Nbatch - 1];
+    }
+}
+
+static void k_make_prn_bitsliced(bench_t *b, int ithread, int cold, unsigned long ibegin, unsigned long iend)
+{
+    unsigned long i, j, icount[Nbatch], iprn[Nbatch];
+
+    for (i = ibegin; i < iend; i += Nbatch)
+    {
+        for (j = 0UL; j < Nbatch; j++) icount[j] = i;
+        make_prn_bitsliced(b->process_data, Nbatch, b->nidents + (cold ? COLD(i) / Nbatch * Nbatch : ithread * Nbatch % Ncold), icount, iprn);
+        b->sink[ithread * 8] ^= iprn[Nbatch - 1];
+    }
+}
+
+static double wtime()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+/* Sweeps a buffer larger than the last-level cache, to evict the tables and states */
+static void flush(unsigned char *buffer)
+{
+    unsigned long i;
+
+    for (i = 0UL; i < Nflush; i += 64) buffer[i]++;
+}
+
+/* Runs calls 0 to ncall - 1 of a benchmark on nthread threads and prints the result as JSON */
+static void run(bench_t *b, unsigned char *buffer, const char *name, kernel_t kernel, unsigned long ncall, unsigned long step,
+                unsigned long bytes, int cold, int nthread, int *first)
+{
+    double t0, t1;
+
+    ncall = (ncall + step * nthread - 1) / (step * nthread) * step * nthread;
+    if (cold) flush(buffer);
+    t0 = wtime();
+    #pragma omp parallel num_threads(nthread)
+    {
+        int ithread = 0;
+        unsigned long n = ncall / nthread;
+#ifdef _OPENMP
+        ithread = omp_get_thread_num();
+#endif
+        kernel(b, ithread, cold, ithread * n, (ithread + 1) * n);
+    }
+    t1 = wtime();
+    printf("%s    {\"name\": \"%s\", \"cache\": \"%s\", \"threads\": %d, \"calls\": %lu, \"seconds\": %.6f, \"ns_per_call\": %.3f, \"gb_per_s\": %.4f}",
+           *first ? "" : ",\n", name, cold ? "cold" : "warm", nthread, ncall, t1 - t0,
+           1.0e9 * (t1 - t0) / ncall, bytes * ncall / (t1 - t0) * 1.0e-9);
+    *first = 0;
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    /* The benchmarks, how many calls they do (times scale), how many calls
+       per step, how many bytes each call produces, and whether it has a cold
+       variant */
+    struct
+    {
+        const char *name;
+        kernel_t kernel;
+        unsigned long ncall, step, bytes;
+        int cold;
+    }
+    benchmarks[] =
+    {
+        {"initialize_common", k_initialize_common, 1UL << 12, 1, sizeof(desprng_common_t), 0},
+        {"create_identifier", k_create_identifier, 1UL << 24, 1, sizeof(unsigned long), 0},
+        {"initialize_individual", k_initialize_individual, 1UL << 19, 1, sizeof(desprng_individual_t), 1},
+        {"_deskey", k_deskey, 1UL << 14, 1, sizeof(desprng_individual_t), 1},
+        {"_deskeyfast", k_deskeyfast, 1UL << 19, 1, sizeof(desprng_individual_t), 1},
+        {"_des", k_des, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"make_prn", k_make_prn, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"make_prn_np1", k_make_prn_np1, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"get_uniform_prn", k_get_uniform_prn, 1UL << 20, 1, sizeof(double), 1},
+        {"make_prn_compact", k_make_prn_compact, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"make_prn_table", k_make_prn_table, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"make_prn_paired", k_make_prn_paired, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"make_prn_ident", k_make_prn_ident, 1UL << 20, 1, sizeof(unsigned long), 1},
+        {"make_prn_range", k_make_prn_range, 1UL << 21, Nbatch, sizeof(unsigned long), 1},
+        {"make_prn_simd", k_make_prn_simd, 1UL << 21, Nbatch, sizeof(unsigned long), 1},
+        {"make_prn_bitsliced", k_make_prn_bitsliced, 1UL << 22, Nbatch, sizeof(unsigned long), 1}
+    };
+    bench_t b;
+    unsigned char *buffer;
+    unsigned long i;
+    double scale = 1.0;
+    char *end;
+    int ibench, cold, nthread, maxthread = 1, first = 1;
+
+    if (argc > 1) scale = strtod(argv[1], &end);
+    /* Zero calls (or a non-number) would put nan or inf rates in the JSON */
+    if (argc > 2 || argc > 1 && (end == argv[1] || *end || !(scale > 0.0 && scale < 1.0e6)))
+    {
+        fprintf(stderr, "Usage: desbench [scale], with scale > 0 (and < 1e6)\n");
+        return 1;
+    }
+#ifdef _OPENMP
+    maxthread = omp_get_max_threads();
+#endif
+
+    b.process_data = malloc(sizeof(desprng_common_t));
+    b.table_data = malloc(sizeof(desprng_table_t));
+    b.pairtable_data = malloc(sizeof(desprng_pairtable_t));
+    b.cold = malloc(sizeof(desprng_individual_t) * Ncold);
+    b.warm = malloc(sizeof(desprng_individual_t) * maxthread);
+    b.compact = malloc(sizeof(desprng_compact_t) * maxthread);
+    b.coldcompact = malloc(sizeof(desprng_compact_t) * Ncold);
+    b.nidents = malloc(sizeof(unsigned long) * Ncold);
+    b.sink = calloc(8 * maxthread, sizeof(unsigned long));
+    buffer = calloc(Nflush, 1);
+    if (!b.process_data || !b.table_data || !b.pairtable_data || !b.cold || !b.warm || !b.compact || !b.coldcompact || !b.nidents || !b.sink || !buffer)
+    {
+        fprintf(stderr, "desbench: out of memory\n");
+        return 1;
+    }
+
+    initialize_common(b.process_data);
+    initialize_table(b.process_data, b.table_data);
+    initialize_pairtable(b.process_data, b.pairtable_data);
+    for (i = 0UL; i < Ncold; i++) b.nidents[i] = i;
+    if (initialize_individuals(b.process_data, b.cold, b.nidents, Ncold))
+    {
+        fprintf(stderr, "desbench: initialize_individuals() failed\n");
+        return 1;
+    }
+    for (i = 0UL; i < Ncold; i++)
+    {
+        b.nidents[i] = b.cold[i].nident;
+        initialize_compact(b.process_data, b.coldcompact + i, b.nidents[i]);
+    }
+    for (i = 0UL; i < (unsigned long)maxthread; i++)
+    {
+        initialize_individual(b.process_data, b.warm + i, b.nidents[i]);
+        initialize_compact(b.process_data, b.compact + i, b.nidents[i]);
+    }
+
+    printf("{\n  \"max_threads\": %d,\n  \"simd_lanes\": %d,\n  \"results\": [\n", maxthread, get_simd_lanes());
+    for (ibench = 0; ibench < (int)(sizeof(benchmarks) / sizeof(benchmarks[0])); ibench++)
+        for (cold = 0; cold <= benchmarks[ibench].cold; cold++)
+            for (nthread = 1; nthread <= maxthread; nthread = nthread < maxthread && 2 * nthread > maxthread ? maxthread : 2 * nthread)
+                run(&b, buffer, benchmarks[ibench].name, benchmarks[ibench].kernel, benchmarks[ibench].ncall * scale,
+                    benchmarks[ibench].step, benchmarks[ibench].bytes, cold, nthread, &first);
+    printf("\n  ]\n}\n");
+
+    free(buffer);
+    free(b.sink);
+    free(b.nidents);
+    free(b.coldcompact);
+    free(b.compact);
+    free(b.warm);
+    free(b.cold);
+    free(b.pairtable_data);
+    free(b.table_data);
+    free(b.process_data);
+
+    return 0;
+}
@@ -0,0 +1,343 @@
+/* Copyright (c) 2020, Johan Carlsson and RadiaSoft LLC
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Bitsliced DES PRNG backend for bulk PRN generation on CPU.
+ * Bit b of every lane (an independent identifier and counter pair) is stored
+ * in word b, so that the 16 DES rounds of all lanes are computed at once with
+ * logical operations alone. There are no table lookups, and no memory
+ * accesses that depend on the data. The S-boxes are evaluated as multiplexer
+ * trees over their truth tables. Since the byte shuffling of _scrunch() and
+ * _unscrun(), the initial and final permutations, and the key schedule only
+ * move bits around, they become a relabeling of the bitsliced words.
+ */
+
+#include "desprng.h"
+
+/* These are the signatures for the des.c functions that we call directly */
+extern void _scrunch(unsigned char *outof, unsigned long *into);
+extern void _unscrun(unsigned long *outof, unsigned char *into);
+extern void _desip(unsigned long *block);
+extern void _desfp(unsigned long *block);
+
+/* A bitsliced word holds one bit of 64 * BS_WORDS lanes. With GCC vector
+   extensions it fills an SSE, AVX2 or AVX-512 register */
+#if defined(__GNUC__) && defined(__AVX512F__)
+#define BS_WORDS 8
+#elif defined(__GNUC__) && defined(__AVX2__)
+#define BS_WORDS 4
+#elif defined(__GNUC__) && defined(__SSE2__)
+#define BS_WORDS 2
+#else
+#define BS_WORDS 1
+#endif
+
+#if BS_WORDS > 1
+/* may_alias, because the parts of the words are also accessed one by one */
+typedef unsigned long bsword_t __attribute__ ((vector_size (8 * BS_WORDS), __may_alias__));
+#else
+typedef unsigned long bsword_t;
+#endif
+
+#define BS_LANES (64 * BS_WORDS)
+
+/* The S-box evaluation is only fast when the truth tables are constants in
+   fully unrolled code */
+#if defined(__GNUC__)
+#define BS_INLINE __inline__ __attribute__ ((always_inline))
+#else
+#define BS_INLINE
+#endif
+
+/* Gives access to the individual 64-bit parts of an array of bitsliced words */
+typedef union
+{
+    bsword_t w[64];
+    unsigned long u[64][BS_WORDS];
+}
+bsblock_t;
+
+/* Where the bitsliced words come from, and where they go */
+typedef struct
+{
+    unsigned char kn[32][32]; /* Bit b of subkey KnL[c] is bit kn[c][b] of the identifier */
+    unsigned char in[64]; /* Bit b of the initially permuted block is bit in[b] of the counter */
+    unsigned char out[64]; /* Bit b of the PRN is bit out[b] of the block before the final permutation */
+}
+bsmap_t;
+
+/* Truth tables of the S-boxes. Bit idx of bstruth[k][o] is output o of
+   SP[k][idx] in initialize_common(), which has bit position bsoutbit[k][o] */
+static const unsigned long bstruth[8][4] =
+{
+    {0x917be9066f81b478UL, 0x27e9d492609f1f29UL, 0xb0c7871b497826bdUL, 0x869d497a86e67619UL},
+    {0x68f93c169346c3e9UL, 0xcd235ad2b865168fUL, 0xe196196e69c3a659UL, 0x746a8b7462949fc3UL},
+    {0x76b9960c39c2b749UL, 0x96692d696b9c90d3UL, 0xd96a863526f4794aUL, 0x4b8d9c63a965569aUL},
+    {0x09b77c1ac34998e7UL, 0x92c3e719ed90583eUL, 0xcb69718c74ca0e97UL, 0xacd1168f692cce71UL},
+    {0xc70b39c692f05d2bUL, 0x695b9ca191666b96UL, 0x429dcd6a79e1348eUL, 0xa4cd96d24b76b948UL},
+    {0xc69938d615e69a69UL, 0x95a36a597c3ca34cUL, 0x52cbe13c6d9216daUL, 0xb44ab695c9a4695bUL},
+    {0x92c761f82c96d966UL, 0x6a95f41a9e4b81f4UL, 0x869cd96699e643c3UL, 0x348e9679497969a6UL},
+    {0x394e96b1596aa569UL, 0x9f6281cd619c7c2bUL, 0xa71658a7c8f13f0cUL, 0xc17abd2438c716b9UL}
+};
+static const unsigned char bsoutbit[8][4] =
+{
+    { 2, 10, 16, 24},
+    { 5, 15, 20, 31},
+    { 3,  9, 17, 27},
+    { 0,  7, 13, 23},
+    { 8, 19, 25, 30},
+    { 4, 14, 22, 29},
+    { 1, 11, 21, 26},
+    { 6, 12, 18, 28}
+};
+
+
+/* Transposes a 64 x 64 bit matrix in place, so that bit j of a[i] swaps
+   places with bit i of a[j] (from "Hacker's Delight" by Henry S. Warren) */
+static void _transpose(unsigned long *a)
+{
+    unsigned long m, t;
+    int j, k;
+
+    for (j = 32, m = 0x00000000ffffffffUL; j; j >>= 1, m ^= m << j)
+        for (k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+
+    return;
+}
+
+
+/* Returns the position of the single set bit of n */
+static unsigned char _bitpos(unsigned long n)
+{
+    unsigned char b;
+
+    for (b = 0; !(n & 1UL); b++) n >>= 1;
+
+    return b;
+}
+
+
+/* Copies the bit positions selected by mask, as if doing (from & mask) << shift */
+static void _bsmove(unsigned char *to, unsigned char *from, unsigned long mask, int shift)
+{
+    int b;
+
+    for (b = 0; b < 32; b++)
+        if ((mask >> b) & 1UL) to[b + shift] = from[b];
+
+    return;
+}
+
+
+/* Finds out where every bit goes, by running the key schedule on bit positions
+   instead of bits, and by pushing single bits through the des.c functions */
+static void _bsmaps(desprng_common_t *process_data, bsmap_t *map)
+{
+    int i, j, l, m, n;
+    unsigned char key[64], pc1m[56], pcr[56], raw[2][32];
+    unsigned long probe, block[2];
+
+    /* Bit t of byte b of a DES key is the identifier bit key[(b << 3) + t] */
+    for (j = 0; j < 64; j++)
+    {
+        probe = 1UL << j;
+        for (l = 0; !((unsigned char *)&probe)[l]; l++);
+        key[(l << 3) + _bitpos(((unsigned char *)&probe)[l])] = j;
+    }
+
+    /* Same as _deskey() and _cookey() */
+    for (j = 0; j < 56; j++)
+    {
+        l = process_data->pc1[j];
+        m = l & 07;
+        pc1m[j] = key[((l >> 3) << 3) + _bitpos(process_data->bytebit[m])];
+    }
+    for (i = 0; i < 16; i++)
+    {
+        m = i << 1;
+        n = m + 1;
+        for (j = 0; j < 28; j++)
+        {
+            l = j + process_data->totrot[i];
+            if (l < 28) pcr[j] = pc1m[l];
+            else pcr[j] = pc1m[l - 28];
+        }
+        for (j = 28; j < 56; j++)
+        {
+            l = j + process_data->totrot[i];
+            if (l < 56) pcr[j] = pc1m[l];
+            else pcr[j] = pc1m[l - 28];
+        }
+        for (j = 0; j < 24; j++)
+        {
+            raw[0][_bitpos(process_data->bigbyte[j])] = pcr[process_data->pc2[j]];
+            raw[1][_bitpos(process_data->bigbyte[j])] = pcr[process_data->pc2[j + 24]];
+        }
+        _bsmove(map->kn[m], raw[0], 0x00fc0000L, 6);
+        _bsmove(map->kn[m], raw[0], 0x00000fc0L, 10);
+        _bsmove(map->kn[m], raw[1], 0x00fc0000L, -10);
+        _bsmove(map->kn[m], raw[1], 0x00000fc0L, -6);
+        _bsmove(map->kn[n], raw[0], 0x0003f000L, 12);
+        _bsmove(map->kn[n], raw[0], 0x0000003fL, 16);
+        _bsmove(map->kn[n], raw[1], 0x0003f000L, -4);
+        _bsmove(map->kn[n], raw[1], 0x0000003fL, 0);
+    }
+
+    /* The block is stored as (left half << 32) | right half */
+    for (j = 0; j < 64; j++)
+    {
+        probe = 1UL << j;
+        _scrunch((unsigned char *)&probe, block);
+        _desip(block);
+        map->in[_bitpos((block[0] << 32) | block[1])] = j;
+
+        block[0] = (1UL << j) >> 32;
+        block[1] = (1UL << j) & 0xffffffffUL;
+        _desfp(block);
+        _unscrun(block, (unsigned char *)&probe);
+        map->out[_bitpos(probe)] = j;
+    }
+
+    return;
+}
+
+
+/* Evaluates S-box k for six bitsliced input words, and XORs the result into out */
+static BS_INLINE void _bssbox(int k, bsword_t *in, bsword_t *out)
+{
+    bsword_t zero = {0}, lo[4], hi[4], f[16], node[16];
+    unsigned long truth;
+    int o, q, s, w;
+
+    /* All 16 Boolean functions of the two least significant input bits.
+       Bit (in[1] << 1 | in[0]) of q is the value of f[q] */
+    lo[0] = zero;
+    lo[1] = ~in[0] & ~in[1];
+    lo[2] = in[0] & ~in[1];
+    lo[3] = ~in[1];
+    hi[0] = zero;
+    hi[1] = ~in[0] & in[1];
+    hi[2] = in[0] & in[1];
+    hi[3] = in[1];
+    for (q = 0; q < 16; q++) f[q] = lo[q & 3] | hi[q >> 2];
+
+#pragma GCC unroll 4
+    for (o = 0; o < 4; o++)
+    {
+        /* The leaves of the tree are picked by the truth table, not by the data */
+        truth = bstruth[k][o];
+#pragma GCC unroll 16
+        for (q = 0; q < 16; q++) node[q] = f[(truth >> (q << 2)) & 15];
+        /* The remaining four input bits select among the leaves */
+#pragma GCC unroll 4
+        for (s = 2, w = 8; s < 6; s++, w >>= 1)
+#pragma GCC unroll 8
+            for (q = 0; q < w; q++)
+                node[q] = node[q << 1] ^ ((node[q << 1] ^ node[(q << 1) + 1]) & in[s]);
+        out[bsoutbit[k][o]] ^= node[0];
+    }
+
+    return;
+}
+
+
+/* One DES round: out ^= f(in, keys), the bitsliced equivalent of one half of
+   the round loop in _desfunc() */
+static BS_INLINE void _bsround(bsword_t *in, bsword_t *out, bsword_t *key, unsigned char *key0, unsigned char *key1)
+{
+    bsword_t work[6];
+    int s, t;
+
+    /* work = ((in << 28) | (in >> 4)) ^ key0 feeds SP[6], SP[4], SP[2] and SP[0] */
+#pragma GCC unroll 4
+    for (s = 0; s < 4; s++)
+    {
+        for (t = 0; t < 6; t++) work[t] = in[((s << 3) + t + 4) & 31] ^ key[key0[(s << 3) + t]];
+        _bssbox(6 - (s << 1), work, out);
+    }
+    /* work = in ^ key1 feeds SP[7], SP[5], SP[3] and SP[1] */
+#pragma GCC unroll 4
+    for (s = 0; s < 4; s++)
+    {
+        for (t = 0; t < 6; t++) work[t] = in[(s << 3) + t] ^ key[key1[(s << 3) + t]];
+        _bssbox(7 - (s << 1), work, out);
+    }
+
+    return;
+}
+
+
+/* Computes n unsigned long PRNs with the bitsliced DES engine, one for each
+   (nident[i], icount[i]) pair. Same output as make_prn(), in batches of BS_LANES */
+int make_prn_bitsliced(desprng_common_t *process_data, unsigned long n, unsigned long *nident, unsigned long *icount, unsigned long *iprn)
+{
+    bsmap_t map;
+    bsblock_t key, count, state;
+    unsigned long rows[64], i0, nlane;
+    unsigned long g, j;
+    int b, round;
+
+    _bsmaps(process_data, &map);
+
+    for (i0 = 0UL; i0 < n; i0 += BS_LANES)
+    {
+        nlane = n - i0 < BS_LANES ? n - i0 : BS_LANES;
+
+        /* Transpose identifiers and counters, 64 lanes at a time.
+           Unused lanes are set to zero */
+        for (g = 0; g < BS_WORDS; g++)
+        {
+            for (j = 0; j < 64; j++)
+                rows[j] = (g << 6) + j < nlane ? nident[i0 + (g << 6) + j] : 0UL;
+            _transpose(rows);
+            for (b = 0; b < 64; b++) key.u[b][g] = rows[b];
+
+            for (j = 0; j < 64; j++)
+                rows[j] = (g << 6) + j < nlane ? icount[i0 + (g << 6) + j] : 0UL;
+            _transpose(rows);
+            for (b = 0; b < 64; b++) count.u[b][g] = rows[b];
+        }
+
+        /* state.w[0..31] is the right half, and state.w[32..63] the left half */
+        for (b = 0; b < 64; b++) state.w[b] = count.w[map.in[b]];
+        for (round = 0; round < 8; round++)
+        {
+            _bsround(state.w, state.w + 32, key.w, map.kn[round << 2], map.kn[(round << 2) + 1]);
+            _bsround(state.w + 32, state.w, key.w, map.kn[(round << 2) + 2], map.kn[(round << 2) + 3]);
+        }
+        for (b = 0; b < 64; b++) count.w[b] = state.w[map.out[b]];
+
+        for (g = 0; g < BS_WORDS; g++)
+        {
+            for (b = 0; b < 64; b++) rows[b] = count.u[b][g];
+            _transpose(rows);
+            for (j = 0; j < 64 && (g << 6) + j < nlane; j++) iprn[i0 + (g << 6) + j] = rows[j];
+        }
+    }
+
+    return 0;
+}
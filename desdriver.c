@@ -0,0 +1,245 @@
+/* Work-stealing parallel driver for particle loops, see desdriver.h */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "desprng.h"
+#include "desdriver.h"
+
+/* The chunk range [first, end) of a share, packed in one word so that it can
+   be updated with a single compare-and-swap */
+#define RANGE(first, end) ((unsigned long)(first) << 32 | (end))
+#define FIRST(range) ((range) >> 32)
+#define END(range) ((range) & 0xffffffffUL)
+
+typedef struct desdriver_worker
+{
+    desdriver_t *driver;
+    long ithread;
+}
+worker_t;
+
+#ifndef __GNUC__
+/* Without the GCC atomic builtins, the ranges are updated under a lock */
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* Signatures for the internal functions */
+static unsigned long _load(unsigned long *range);
+static void _store(unsigned long *range, unsigned long value);
+static int _cas(unsigned long *range, unsigned long *expected, unsigned long desired);
+static int _take(desdriver_thread_t *thread, unsigned long *ichunk);
+static int _steal(desdriver_t *driver, long ithread);
+static void *_worker(void *arg);
+
+
+static unsigned long _load(unsigned long *range)
+{
+#ifdef __GNUC__
+    return __atomic_load_n(range, __ATOMIC_ACQUIRE);
+#else
+    unsigned long value;
+
+    pthread_mutex_lock(&_lock);
+    value = *range;
+    pthread_mutex_unlock(&_lock);
+    return value;
+#endif
+}
+
+
+static void _store(unsigned long *range, unsigned long value)
+{
+#ifdef __GNUC__
+    __atomic_store_n(range, value, __ATOMIC_RELEASE);
+#else
+    pthread_mutex_lock(&_lock);
+    *range = value;
+    pthread_mutex_unlock(&_lock);
+#endif
+
+    return;
+}
+
+
+/* Sets *range to desired and returns 1 if it is *expected, or else sets
+   *expected to *range and returns 0 */
+static int _cas(unsigned long *range, unsigned long *expected, unsigned long desired)
+{
+#ifdef __GNUC__
+    return __atomic_compare_exchange_n(range, expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    int equal;
+
+    pthread_mutex_lock(&_lock);
+    if (equal = *range == *expected)
+        *range = desired;
+    else
+        *expected = *range;
+    pthread_mutex_unlock(&_lock);
+    return equal;
+#endif
+}
+
+
+/* Takes the first chunk of the share of thread, and returns 1, or 0 if the share is empty */
+static int _take(desdriver_thread_t *thread, unsigned long *ichunk)
+{
+    unsigned long range = _load(&thread->range);
+
+    while (FIRST(range) < END(range))
+        if (_cas(&thread->range, &range, RANGE(FIRST(range) + 1, END(range))))
+        {
+            *ichunk = FIRST(range);
+            return 1;
+        }
+
+    return 0;
+}
+
+
+/* Moves the back half of the share of another thread (the first one found, in
+   the order ithread + 1, ithread + 2, ...) to thread ithread, whose share is
+   empty. Returns 1, or 0 if all the shares are empty */
+static int _steal(desdriver_t *driver, long ithread)
+{
+    desdriver_thread_t *victim;
+    unsigned long range, half;
+    long i;
+
+    for (i = 1; i < driver->nthread; i++)
+    {
+        victim = driver->threads + (ithread + i) % driver->nthread;
+        range = _load(&victim->range);
+        while (FIRST(range) < END(range))
+        {
+            half = (END(range) - FIRST(range) + 1) / 2;
+            if (_cas(&victim->range, &range, RANGE(FIRST(range), END(range) - half)))
+            {
+                /* The stolen chunks are only ours until they are published */
+                _store(&driver->threads[ithread].range, RANGE(END(range) - half, END(range)));
+                driver->threads[ithread].nsteal++;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+static void *_worker(void *arg)
+{
+    desdriver_t *driver = ((worker_t *)arg)->driver;
+    long ithread = ((worker_t *)arg)->ithread;
+    desdriver_thread_t *thread = driver->threads + ithread;
+    unsigned long ichunk, iend;
+
+    do
+        while (_take(thread, &ichunk))
+        {
+            iend = (ichunk + 1) * driver->chunk < driver->nitem ? (ichunk + 1) * driver->chunk : driver->nitem;
+            driver->kernel(driver->arg, &thread->scratch, ichunk * driver->chunk, iend, driver->partial + ichunk * driver->npartial);
+        }
+    while (_steal(driver, ithread));
+
+    return NULL;
+}
+
+
+/* Sets up a driver for nthread threads and the nitem particles in chunks of
+   chunk, each with npartial partial results. Returns 0, -1 for bad arguments
+   (more than 2**32 chunks) and -2 if out of memory */
+int desdriver_init(desdriver_t *driver, long nthread, unsigned long nitem, unsigned long chunk, unsigned long npartial)
+{
+    if (nthread < 1 || !chunk) return -1;
+    driver->nthread = nthread;
+    driver->nitem = nitem;
+    driver->chunk = chunk;
+    driver->nchunk = (nitem + chunk - 1) / chunk;
+    driver->npartial = npartial;
+    if (driver->nchunk >> 32) return -1;
+
+    if (!(driver->partial = malloc(sizeof(double) * (driver->nchunk * npartial + 1)))) return -2;
+    if (posix_memalign((void **)&driver->threads, 64, sizeof(desdriver_thread_t) * nthread))
+    {
+        free(driver->partial);
+        return -2;
+    }
+    memset(driver->threads, 0, sizeof(desdriver_thread_t) * nthread);
+
+    return 0;
+}
+
+
+/* Calls kernel(arg, ...) for all the chunks, on driver->nthread threads, and
+   sets result[0..npartial-1] to the sums of the partial results, added up in
+   chunk order. Returns 0, or -2 if a thread could not be started */
+int desdriver_run(desdriver_t *driver, desdriver_kernel_t kernel, void *arg, double *result)
+{
+    pthread_t *pthreads;
+    worker_t *workers;
+    unsigned long ichunk, i;
+    long ithread, nstarted;
+    int ierr = 0;
+
+    driver->kernel = kernel;
+    driver->arg = arg;
+    memset(driver->partial, 0, sizeof(double) * driver->nchunk * driver->npartial);
+    /* Equal shares to begin with */
+    for (ithread = 0; ithread < driver->nthread; ithread++)
+        driver->threads[ithread].range = RANGE(driver->nchunk * ithread / driver->nthread, driver->nchunk * (ithread + 1) / driver->nthread);
+
+    if (!(pthreads = malloc(sizeof(pthread_t) * driver->nthread))) return -2;
+    if (!(workers = malloc(sizeof(worker_t) * driver->nthread)))
+    {
+        free(pthreads);
+        return -2;
+    }
+    /* Thread 0 is the calling thread */
+    for (nstarted = 1; nstarted < driver->nthread; nstarted++)
+    {
+        workers[nstarted].driver = driver;
+        workers[nstarted].ithread = nstarted;
+        if (pthread_create(pthreads + nstarted, NULL, _worker, workers + nstarted))
+        {
+            ierr = -2;
+            break;
+        }
+    }
+    workers[0].driver = driver;
+    workers[0].ithread = 0;
+    /* If not all threads started, the others steal their shares */
+    _worker(workers);
+    for (ithread = 1; ithread < nstarted; ithread++) pthread_join(pthreads[ithread], NULL);
+    free(workers);
+    free(pthreads);
+
+    for (i = 0UL; i < driver->npartial; i++) result[i] = 0.0;
+    for (ichunk = 0UL; ichunk < driver->nchunk; ichunk++)
+        for (i = 0UL; i < driver->npartial; i++) result[i] += driver->partial[ichunk * driver->npartial + i];
+
+    return ierr;
+}
+
+
+/* Returns the number of steals so far */
+unsigned long desdriver_steals(desdriver_t *driver)
+{
+    unsigned long nsteal = 0UL;
+    long ithread;
+
+    for (ithread = 0; ithread < driver->nthread; ithread++) nsteal += driver->threads[ithread].nsteal;
+
+    return nsteal;
+}
+
+
+void desdriver_free(desdriver_t *driver)
+{
+    free(driver->threads);
+    free(driver->partial);
+
+    return;
+}
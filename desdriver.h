@@ -0,0 +1,58 @@
+/* This is the header file for desdriver, a work-stealing parallel driver for
+ * particle loops that use the DES PRNG (CPU only, with POSIX threads).
+ *
+ * The particles 0, 1, ..., nitem - 1 are split into chunks, and each thread
+ * starts out with an equal share of the chunks. A thread takes chunks from
+ * the front of its share, and when it runs out, it steals the back half of
+ * the share of another thread. A chunk is handed to a kernel together with
+ * a desprng_individual_t that belongs to the thread (for the kernel to
+ * initialize for each particle, instead of keeping one per particle) and an
+ * array of npartial doubles for the partial results of the chunk (e.g. sums).
+ * The partial results are added up in chunk order at the end, so as long as
+ * the kernel only depends on the particle numbers and counters, the results
+ * are bit-identical for any number of threads and any order of stealing.
+ */
+
+#ifndef DESDRIVER_H
+#define DESDRIVER_H
+
+/* desprng.h must be included first */
+
+/* Does the particles ibegin to iend - 1, and adds to partial[0..npartial-1] */
+typedef void (*desdriver_kernel_t)(void *arg, desprng_individual_t *scratch, unsigned long ibegin, unsigned long iend, double *partial);
+
+/* What a thread owns. With GCC and compatible compilers, range (which the
+   thieves poll) and scratch (which the owner rewrites for every particle) are
+   on cache lines of their own, and so is every thread in an array of them */
+typedef struct desdriver_thread
+{
+    unsigned long range; /* The chunks left in its share, first << 32 | end */
+    unsigned long nsteal;
+#ifdef __GNUC__
+    desprng_individual_t scratch __attribute__ ((aligned (64)));
+#else
+    desprng_individual_t scratch;
+#endif
+}
+#ifdef __GNUC__
+__attribute__ ((aligned (64)))
+#endif
+desdriver_thread_t;
+
+typedef struct desdriver
+{
+    long nthread;
+    unsigned long nitem, chunk, nchunk, npartial;
+    double *partial; /* npartial per chunk */
+    desdriver_thread_t *threads;
+    desdriver_kernel_t kernel;
+    void *arg;
+}
+desdriver_t;
+
+int desdriver_init(desdriver_t *driver, long nthread, unsigned long nitem, unsigned long chunk, unsigned long npartial);
+int desdriver_run(desdriver_t *driver, desdriver_kernel_t kernel, void *arg, double *result);
+unsigned long desdriver_steals(desdriver_t *driver);
+void desdriver_free(desdriver_t *driver);
+
+#endif
@@ -0,0 +1,131 @@
+/* Copyright (c) 2020, Johan Carlsson and RadiaSoft LLC
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Buffer fills (CPU only) that compute one PRN per stream for a common
+ * counter, straight into an array owned by the caller. The streams are done
+ * in chunks by make_prn_simd(), the key schedules of the next chunk are
+ * prefetched while the current one is encrypted, and buffers larger than
+ * FILL_STREAM_BYTES are written with non-temporal stores, so they do not
+ * evict the tables and key schedules from cache. The chunks are spread over
+ * threads when compiled with OpenMP.
+ */
+
+#include <string.h>
+#include "desprng.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__NVCOMPILER)
+#define DESPRNG_STREAM
+#include <immintrin.h>
+#endif
+
+/* Number of streams that are encrypted (and prefetched) at a time */
+#define FILL_CHUNK 64
+/* Buffers at least this large (in bytes) are written with non-temporal stores */
+#define FILL_STREAM_BYTES 4194304UL
+
+/* 2**-64, which makes the doubles the same as those of get_uniform_prn() */
+#define FILL_TWOM64 5.42101086242752217003726400434970855712890625e-20
+
+/* Signatures for the internal functions */
+static void _prefetch(desprng_individual_t *states, unsigned long n);
+static void _fill(desprng_common_t *process_data, desprng_individual_t *states, unsigned long n_streams, unsigned long icount, unsigned long *out, int todouble);
+
+
+/* Prefetches the part of the states that DES reads (nident and KnL) */
+static void _prefetch(desprng_individual_t *states, unsigned long n)
+{
+#ifdef __GNUC__
+    unsigned long i;
+    unsigned j;
+
+    for (i = 0UL; i < n; i++)
+        for (j = 0; j < sizeof(unsigned long) * 33; j += 64)
+            __builtin_prefetch((char *)(states + i) + j, 0, 3);
+#endif
+    return;
+}
+
+
+static void _fill(desprng_common_t *process_data, desprng_individual_t *states, unsigned long n_streams, unsigned long icount, unsigned long *out, int todouble)
+{
+    unsigned long ichunk, nchunk = (n_streams + FILL_CHUNK - 1) / FILL_CHUNK;
+#ifdef DESPRNG_STREAM
+    int stream = n_streams * sizeof(unsigned long) >= FILL_STREAM_BYTES;
+#endif
+
+    #pragma omp parallel
+    {
+        unsigned long icounts[FILL_CHUNK], iprn[FILL_CHUNK], i, j, m;
+        double xprn;
+
+        for (j = 0UL; j < FILL_CHUNK; j++) icounts[j] = icount;
+
+        #pragma omp for schedule(static)
+        for (ichunk = 0UL; ichunk < nchunk; ichunk++)
+        {
+            i = ichunk * FILL_CHUNK;
+            m = n_streams - i < FILL_CHUNK ? n_streams - i : FILL_CHUNK;
+            if (i + m < n_streams)
+                _prefetch(states + i + m, n_streams - i - m < FILL_CHUNK ? n_streams - i - m : FILL_CHUNK);
+            make_prn_simd(process_data, states + i, m, icounts, iprn);
+            if (todouble)
+                for (j = 0UL; j < m; j++)
+                {
+                    xprn = iprn[j] * FILL_TWOM64;
+                    memcpy(iprn + j, &xprn, sizeof(double));
+                }
+#ifdef DESPRNG_STREAM
+            if (stream)
+                for (j = 0UL; j < m; j++) _mm_stream_si64((long long *)(out + i + j), (long long)iprn[j]);
+            else
+#endif
+                memcpy(out + i, iprn, m * sizeof(unsigned long));
+        }
+#ifdef DESPRNG_STREAM
+        /* Make the non-temporal stores of this thread visible to the others */
+        if (stream) _mm_sfence();
+#endif
+    }
+
+    return;
+}
+
+
+/* Computes one unsigned long PRN per stream, out[i] for states[i] and the
+   common counter icount, with the same output as make_prn() */
+int desprng_fill_u64(desprng_common_t *process_data, desprng_individual_t *states, unsigned long n_streams, unsigned long icount, unsigned long *out)
+{
+    _fill(process_data, states, n_streams, icount, out, 0);
+
+    return 0;
+}
+
+
+/* Same as desprng_fill_u64(), but with the same double-precision floats,
+   uniform in the range [0, 1), as get_uniform_prn() returns */
+int desprng_fill_double(desprng_common_t *process_data, desprng_individual_t *states, unsigned long n_streams, unsigned long icount, double *out)
+{
+    _fill(process_data, states, n_streams, icount, (unsigned long *)out, 1);
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/* Copyright (c) 2020, Johan Carlsson and RadiaSoft LLC
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Key-schedule cache files (CPU only, POSIX), which hold the expanded
+ * identifiers of a population of particles with consecutive particle numbers,
+ * so that restarts and parameter sweeps can map them instead of calling
+ * initialize_individual() (or initialize_compact()) for every particle. The
+ * file is a header page followed by the array of desprng_individual_t or
+ * desprng_compact_t (the layout), where entry i is for particle number
+ * nparticle_first + i. The header records the layout, the size of an entry, the
+ * byte order and the number of subkey pairs (rounds), and a file that does not
+ * match the library that maps it is rejected. The array is mapped read-only and
+ * shared, so all the processes on a node share one copy in the page cache.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "desprng.h"
+
+#define DESMAP_MAGIC "DESPRNGK"
+#define DESMAP_VERSION 1
+/* Read back as this value only if the file has the byte order of the reader */
+#define DESMAP_ENDIAN 0x0102030405060708UL
+/* Offset of the array, a page so the entries are page aligned once mapped */
+#define DESMAP_DATA 4096UL
+
+typedef struct desprng_map_header
+{
+    char magic[8];
+    unsigned version;
+    unsigned layout;
+    unsigned long endian;
+    unsigned rounds;
+    unsigned size;
+    unsigned long n;
+    unsigned long nparticle_first;
+}
+desmap_header_t;
+
+/* Signatures for the internal functions */
+static unsigned _entry_size(int layout);
+
+
+static unsigned _entry_size(int layout)
+{
+    if (layout == DESPRNG_LAYOUT_INDIVIDUAL) return sizeof(desprng_individual_t);
+    if (layout == DESPRNG_LAYOUT_COMPACT) return sizeof(desprng_compact_t);
+    return 0;
+}
+
+
+/* Writes the n key schedules in data (an array of desprng_individual_t or
+   desprng_compact_t, as given by layout) for the particle numbers
+   nparticle_first, nparticle_first + 1, ... to filename. The file is written
+   under a temporary name and renamed, so a reader never maps a partial file.
+   Returns 0, -1 for a bad layout and -2 if the file could not be written */
+int desprng_write_schedules(const char *filename, int layout, const void *data, unsigned long n, unsigned long nparticle_first)
+{
+    char header[DESMAP_DATA], *tmpname;
+    desmap_header_t *h = (desmap_header_t *)header;
+    const char *p;
+    unsigned long nbyte;
+    ssize_t nwritten;
+    int fd, ierr = 0;
+
+    if (!_entry_size(layout)) return -1;
+    memset(header, 0, DESMAP_DATA);
+    memcpy(h->magic, DESMAP_MAGIC, 8);
+    h->version = DESMAP_VERSION;
+    h->layout = layout;
+    h->endian = DESMAP_ENDIAN;
+    h->rounds = 16;
+    h->size = _entry_size(layout);
+    h->n = n;
+    h->nparticle_first = nparticle_first;
+
+    if (!(tmpname = malloc(strlen(filename) + 5))) return -2;
+    sprintf(tmpname, "%s.tmp", filename);
+    if ((fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+        free(tmpname);
+        return -2;
+    }
+    /* The header page, then the array */
+    for (p = header, nbyte = DESMAP_DATA; nbyte && !ierr; p += nwritten, nbyte -= nwritten)
+        if ((nwritten = write(fd, p, nbyte)) <= 0) ierr = -2;
+    for (p = data, nbyte = n * h->size; nbyte && !ierr; p += nwritten, nbyte -= nwritten)
+        if ((nwritten = write(fd, p, nbyte)) <= 0) ierr = -2;
+    if (close(fd) || (!ierr && rename(tmpname, filename))) ierr = -2;
+    if (ierr) unlink(tmpname);
+    free(tmpname);
+
+    return ierr;
+}
+
+
+/* Maps the key schedules in filename read-only, sets *data to the array, and
+   *n and *nparticle_first to the number of entries and the particle number of
+   the first one. The array must not be written to, and is released with
+   desprng_unmap_schedules(). Returns 0, -1 for a bad layout, -2 if the file
+   could not be mapped, -3 if it is not a key-schedule cache file (or has
+   the wrong size), and -4 if it was written with another layout, byte order or
+   version of the library */
+int desprng_map_schedules(const char *filename, int layout, void **data, unsigned long *n, unsigned long *nparticle_first)
+{
+    desmap_header_t *h;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (!_entry_size(layout)) return -1;
+    if ((fd = open(filename, O_RDONLY)) < 0) return -2;
+    if (fstat(fd, &st))
+    {
+        close(fd);
+        return -2;
+    }
+    if ((unsigned long)st.st_size < DESMAP_DATA)
+    {
+        close(fd);
+        return -3;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -2;
+
+    h = (desmap_header_t *)map;
+    if (memcmp(h->magic, DESMAP_MAGIC, 8) || (unsigned long)st.st_size != DESMAP_DATA + h->n * h->size)
+    {
+        munmap(map, st.st_size);
+        return -3;
+    }
+    if (h->version != DESMAP_VERSION || h->endian != DESMAP_ENDIAN || h->layout != (unsigned)layout || h->rounds != 16 || h->size != _entry_size(layout))
+    {
+        munmap(map, st.st_size);
+        return -4;
+    }
+
+    *data = (char *)map + DESMAP_DATA;
+    *n = h->n;
+    *nparticle_first = h->nparticle_first;
+
+    return 0;
+}
+
+
+/* Releases key schedules mapped by desprng_map_schedules() */
+int desprng_unmap_schedules(void *data)
+{
+    desmap_header_t *h = (desmap_header_t *)((char *)data - DESMAP_DATA);
+
+    return munmap(h, DESMAP_DATA + h->n * h->size) ? -2 : 0;
+}
@@ -0,0 +1,248 @@
+/* Copyright (c) 2020, Johan Carlsson and RadiaSoft LLC
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* NUMA placement (CPU only, Linux, POSIX threads). All threads read the SP
+ * tables of desprng_common_t for every PRN, and on a multi-socket node a copy
+ * on another socket costs a remote miss for each lookup that falls out of the
+ * local caches. desprng_numa_init() reads the node layout from sysfs and builds
+ * one desprng_common_t per node, allocated and initialized (and so placed, by
+ * the first-touch policy) by a thread pinned to the CPUs of that node, and
+ * desprng_numa_common() hands a thread the copy of the node it runs on. The
+ * threads should be pinned (e.g. OMP_PROC_BIND=close) for this to stay local.
+ * desprng_numa_individuals() allocates an array of desprng_individual_t whose
+ * parts are first touched on the nodes in turn, in proportion to their CPUs,
+ * which is where a static schedule over pinned threads puts the threads that
+ * use them. Without sysfs (or on one node), everything is on node 0.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "desprng.h"
+
+#define DESNUMA_SYSFS "/sys/devices/system/node"
+#define DESNUMA_PAGE 4096UL
+
+typedef struct desprng_numa_task
+{
+    void *data; /* What the pinned thread touches (or allocates, if NULL) */
+    unsigned long size;
+}
+task_t;
+
+/* Signatures for the internal functions */
+static int _readlist(const char *filename, unsigned char *set, int nset);
+static void *_touch(void *arg);
+static int _onnode(desprng_numa_t *numa, int inode, void *data, unsigned long size, void **result);
+
+
+/* Reads a sysfs list like 0-3,8-11 into set[0..nset-1] (1 for listed). Returns
+   the number listed, or -1 if the file cannot be read */
+static int _readlist(const char *filename, unsigned char *set, int nset)
+{
+    FILE *in;
+    int first, last, n = 0;
+    char sep;
+
+    if (!(in = fopen(filename, "r"))) return -1;
+    memset(set, 0, nset);
+    while (fscanf(in, "%d", &first) == 1)
+    {
+        last = first;
+        if ((sep = fgetc(in)) == '-')
+        {
+            if (fscanf(in, "%d", &last) != 1) break;
+            sep = fgetc(in);
+        }
+        for (; first <= last; first++)
+            if (first >= 0 && first < nset && !set[first])
+            {
+                set[first] = 1;
+                n++;
+            }
+        if (sep != ',') break;
+    }
+    fclose(in);
+
+    return n;
+}
+
+
+/* Runs on a thread pinned to a node. Zeroes task->data, or allocates and
+   initializes a desprng_common_t if it is NULL */
+static void *_touch(void *arg)
+{
+    task_t *task = arg;
+
+    if (task->data)
+        memset(task->data, 0, task->size);
+    else if (!posix_memalign(&task->data, DESNUMA_PAGE, task->size))
+        initialize_common(task->data);
+
+    return NULL;
+}
+
+
+/* Does _touch() for size bytes at data (or a new desprng_common_t) on a thread
+   pinned to the CPUs of node inode, or on this thread if that fails. Returns
+   0 (with the new desprng_common_t in *result), or -2 if out of memory */
+static int _onnode(desprng_numa_t *numa, int inode, void *data, unsigned long size, void **result)
+{
+    task_t task;
+    pthread_attr_t attr;
+    pthread_t thread;
+    cpu_set_t cpus;
+    int icpu, pinned = 0;
+
+    task.data = data;
+    task.size = size;
+
+    CPU_ZERO(&cpus);
+    for (icpu = 0; icpu < numa->ncpu && icpu < CPU_SETSIZE; icpu++)
+        if (numa->node_of_cpu[icpu] == inode) CPU_SET(icpu, &cpus);
+    if (numa->nnode > 1 && !pthread_attr_init(&attr))
+    {
+        if (!pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpus) && !pthread_create(&thread, &attr, _touch, &task))
+        {
+            pthread_join(thread, NULL);
+            pinned = 1;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    /* Still correct, just not placed */
+    if (!pinned) _touch(&task);
+
+    if (result) *result = task.data;
+    return task.data ? 0 : -2;
+}
+
+
+/* Finds the NUMA nodes and their CPUs, and initializes one desprng_common_t
+   per node on that node. Returns 0, or -2 if out of memory */
+int desprng_numa_init(desprng_numa_t *numa)
+{
+    unsigned char nodes[CPU_SETSIZE], cpus[CPU_SETSIZE];
+    char filename[64];
+    int inode, icpu, node;
+
+    memset(numa, 0, sizeof(desprng_numa_t));
+    if (!(numa->node_of_cpu = malloc(sizeof(int) * CPU_SETSIZE))) return -2;
+    for (icpu = 0; icpu < CPU_SETSIZE; icpu++) numa->node_of_cpu[icpu] = -1;
+
+    /* The online nodes, numbered 0, 1, ... in the order of their ids */
+    if (_readlist(DESNUMA_SYSFS "/online", nodes, CPU_SETSIZE) > 0)
+        for (node = 0; node < CPU_SETSIZE; node++)
+        {
+            if (!nodes[node]) continue;
+            sprintf(filename, DESNUMA_SYSFS "/node%d/cpulist", node);
+            /* Nodes with memory but no CPUs get no copy */
+            if (_readlist(filename, cpus, CPU_SETSIZE) <= 0) continue;
+            for (icpu = 0; icpu < CPU_SETSIZE; icpu++)
+                if (cpus[icpu])
+                {
+                    numa->node_of_cpu[icpu] = numa->nnode;
+                    if (icpu >= numa->ncpu) numa->ncpu = icpu + 1;
+                }
+            numa->nnode++;
+        }
+    if (!numa->nnode)
+    {
+        /* No sysfs, so one node with all the CPUs */
+        numa->nnode = 1;
+        numa->ncpu = sysconf(_SC_NPROCESSORS_CONF) < CPU_SETSIZE ? sysconf(_SC_NPROCESSORS_CONF) : CPU_SETSIZE;
+        for (icpu = 0; icpu < numa->ncpu; icpu++) numa->node_of_cpu[icpu] = 0;
+    }
+
+    if (!(numa->common = calloc(numa->nnode, sizeof(desprng_common_t *))))
+    {
+        desprng_numa_free(numa);
+        return -2;
+    }
+    for (inode = 0; inode < numa->nnode; inode++)
+        if (_onnode(numa, inode, NULL, sizeof(desprng_common_t), (void **)numa->common + inode))
+        {
+            desprng_numa_free(numa);
+            return -2;
+        }
+
+    return 0;
+}
+
+
+/* Returns the node (0 to numa->nnode - 1) of the CPU that the calling thread runs on */
+int desprng_numa_node(desprng_numa_t *numa)
+{
+    int icpu = sched_getcpu();
+
+    return icpu >= 0 && icpu < numa->ncpu && numa->node_of_cpu[icpu] >= 0 ? numa->node_of_cpu[icpu] : 0;
+}
+
+
+/* Returns the copy of desprng_common_t on the node of the calling thread */
+desprng_common_t *desprng_numa_common(desprng_numa_t *numa)
+{
+    return numa->common[desprng_numa_node(numa)];
+}
+
+
+/* Allocates a zeroed array of n desprng_individual_t (to be freed with free()),
+   split between the nodes in proportion to their number of CPUs, in node
+   order. Returns NULL if out of memory */
+desprng_individual_t *desprng_numa_individuals(desprng_numa_t *numa, unsigned long n)
+{
+    desprng_individual_t *thread_data;
+    unsigned long ibegin, iend, size = sizeof(desprng_individual_t) * n, ncpu = 0UL, nbefore = 0UL;
+    int inode, icpu;
+
+    /* Whole pages, so that no page is first touched here */
+    if (posix_memalign((void **)&thread_data, DESNUMA_PAGE, (size + DESNUMA_PAGE - 1) / DESNUMA_PAGE * DESNUMA_PAGE)) return NULL;
+    for (icpu = 0; icpu < numa->ncpu; icpu++) ncpu += numa->node_of_cpu[icpu] >= 0;
+    for (inode = 0; inode < numa->nnode; inode++)
+    {
+        ibegin = n * nbefore / ncpu;
+        for (icpu = 0; icpu < numa->ncpu; icpu++) nbefore += numa->node_of_cpu[icpu] == inode;
+        iend = n * nbefore / ncpu;
+        if (iend > ibegin) _onnode(numa, inode, thread_data + ibegin, sizeof(desprng_individual_t) * (iend - ibegin), NULL);
+    }
+
+    return thread_data;
+}
+
+
+void desprng_numa_free(desprng_numa_t *numa)
+{
+    int inode;
+
+    if (numa->common)
+        for (inode = 0; inode < numa->nnode; inode++) free(numa->common[inode]);
+    free(numa->common);
+    free(numa->node_of_cpu);
+    numa->common = NULL;
+    numa->node_of_cpu = NULL;
+
+    return;
+}
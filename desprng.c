@@ -22,13 +22,49 @@
  */
 
 #include <limits.h>
+#include <math.h>
 #include "desprng.h"
 
+/* 2**-32, and 2 pi times that, for turning 32-bit halves of a PRN into doubles */
+#define DESPRNG_TWOM32 2.3283064365386962890625e-10
+#define DESPRNG_TWOPITWOM32 1.4629180792671596e-09
+/* 2**-53 and 2**-24, for 53-bit doubles and 24-bit floats */
+#define DESPRNG_TWOM53 1.1102230246251565404236316680908203125e-16
+#define DESPRNG_TWOM24 5.9604644775390625e-08f
+
 /* These are the signatures for the des.c functions that we call directly */
 #pragma acc routine(_deskey) seq
 extern void _deskey(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key);
+#pragma acc routine(_deskeyfast) seq
+extern void _deskeyfast(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key);
 #pragma acc routine(_des) seq
 extern void _des(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *inblock, unsigned char *outblock);
+#pragma acc routine(_desword) seq
+extern unsigned long _desword(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long inword);
+#pragma acc routine(_deswordnp1) seq
+extern unsigned long _deswordnp1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long inword);
+#pragma acc routine(_desrounds) seq
+extern unsigned long _desrounds(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long inword, int rounds);
+#pragma acc routine(_deskey32) seq
+extern void _deskey32(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned char *key);
+#pragma acc routine(_des32) seq
+extern void _des32(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned char *inblock, unsigned char *outblock);
+#pragma acc routine(_destab) seq
+extern void _destab(desprng_table_t *table_data, desprng_compact_t *compact_data, unsigned char *inblock, unsigned char *outblock);
+#pragma acc routine(_despair) seq
+extern void _despair(desprng_pairtable_t *pairtable_data, desprng_compact_t *compact_data, unsigned char *inblock, unsigned char *outblock);
+#pragma acc routine(_desident) seq
+extern void _desident(desprng_common_t *process_data, unsigned char *key, unsigned char *inblock, unsigned char *outblock);
+#pragma acc routine(_desrange) seq
+extern void _desrange(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long n, unsigned long *iprn);
+
+/* Internal to this file */
+#pragma acc routine(_boxmuller) seq
+static void _boxmuller(unsigned long iprn, double *xnormal);
+#pragma acc routine(_todouble53) seq
+static double _todouble53(unsigned long iprn, unsigned long orbit, unsigned long add);
+#pragma acc routine(_interval53) seq
+static int _interval53(int interval, unsigned long *orbit, unsigned long *add);
 
 
 /* Takes the 56 least significant bits of an unsigned long and splits them into
@@ -67,32 +103,291 @@ int initialize_individual(desprng_common_t *process_data, desprng_individual_t *
     unsigned i;
 
     thread_data->nident = nident;
+    /* KnR and Kn3 are not used, but are zeroed so that the whole state is
+       defined (e.g. when written to a key-schedule cache file) */
     for (i = 0; i < 32; i++)
-        thread_data->Kn3[i] = thread_data->KnR[i] = thread_data->KnL[i] = 0UL;
-
-    _deskey(process_data, thread_data, (unsigned char *)&nident);
+        thread_data->Kn3[i] = thread_data->KnR[i] = 0UL;
+    _deskeyfast(process_data, thread_data, (unsigned char *)&nident);
 
     return 0;
 }
 
 
+/* Creates identifiers from the n particle numbers nparticle[i] (which are
+   not changed), and initializes thread_data[i] with them. The loop runs in
+   parallel when compiled with OpenMP. Returns -1 if a particle number is too
+   large for create_identifier() (the other ones are still initialized) */
+int initialize_individuals(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long *nparticle, unsigned long n)
+{
+    unsigned long i, nident;
+    unsigned j;
+    int ierr = 0;
+
+    #pragma omp parallel for private(nident, j) reduction(min: ierr) schedule(static)
+    for (i = 0UL; i < n; i++)
+    {
+        nident = nparticle[i];
+        if (create_identifier(&nident))
+        {
+            ierr = -1;
+            continue;
+        }
+        thread_data[i].nident = nident;
+        for (j = 0; j < 32; j++)
+            thread_data[i].Kn3[j] = thread_data[i].KnR[j] = 0UL;
+        _deskeyfast(process_data, thread_data + i, (unsigned char *)&nident);
+    }
+
+    return ierr;
+}
+
+
 /* Computes an unsigned long PRN */
 int make_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
 {
-    _des(process_data, thread_data, (unsigned char *)&icount, (unsigned char *)iprn);
+    *iprn = _desword(process_data, thread_data, icount);
 
     return 0;
 }
 
 
+/* Same as make_prn(), but returns the PRN */
+unsigned long make_prn_word(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount)
+{
+    return _desword(process_data, thread_data, icount);
+}
+
+
 /* Returns a PRN in the form of double-precision float, uniform in the range [0, 1) */
 double get_uniform_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
 {
-    _des(process_data, thread_data, (unsigned char *)&icount, (unsigned char *)iprn);
+    *iprn = _desword(process_data, thread_data, icount);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+/* Reduced-round tiers of make_prn() and get_uniform_prn() that run 8, 10 or 12
+   of the 16 DES rounds. They are faster, but give other PRNs, and their
+   statistical quality has not been established by the Crush battery yet */
+int make_prn8(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _desrounds(process_data, thread_data, icount, 8);
+
+    return 0;
+}
+
+
+int make_prn10(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _desrounds(process_data, thread_data, icount, 10);
+
+    return 0;
+}
+
+
+int make_prn12(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _desrounds(process_data, thread_data, icount, 12);
+
+    return 0;
+}
+
+
+double get_uniform_prn8(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _desrounds(process_data, thread_data, icount, 8);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+double get_uniform_prn10(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _desrounds(process_data, thread_data, icount, 10);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+double get_uniform_prn12(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _desrounds(process_data, thread_data, icount, 12);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+/* Initializes the compact DES PRNG data used by individual threads */
+int initialize_compact(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned long nident)
+{
+    compact_data->nident = nident;
+    _deskey32(process_data, compact_data, (unsigned char *)&nident);
+
+    return 0;
+}
+
+
+/* Same as make_prn(), but with the compact state */
+int make_prn_compact(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn)
+{
+    _des32(process_data, compact_data, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return 0;
+}
+
+
+/* Same as get_uniform_prn(), but with the compact state */
+double get_uniform_prn_compact(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn)
+{
+    _des32(process_data, compact_data, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+/* Copies the SP arrays into the 32-bit table used by make_prn_table() */
+int initialize_table(desprng_common_t *process_data, desprng_table_t *table_data)
+{
+    unsigned char i, j;
+
+    for (i = 0; i < 8; i++)
+        for (j = 0; j < 64; j++)
+            table_data->SP[i][j] = process_data->SP[i][j];
+
+    return 0;
+}
+
+
+/* Merges the SP arrays in the pairs that are looked up with the same 12 bits
+   (see _desfpair() in des.c) into the tables used by make_prn_paired() */
+int initialize_pairtable(desprng_common_t *process_data, desprng_pairtable_t *pairtable_data)
+{
+    /* The pairs of S-boxes, with the one for the low 6 bits of the index first */
+    const unsigned char pair[4][2] = {{6, 4}, {2, 0}, {7, 5}, {3, 1}};
+    unsigned i, j;
+
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4096; j++)
+            pairtable_data->SP[i][j] = process_data->SP[pair[i][0]][j & 0x3f] | process_data->SP[pair[i][1]][j >> 6];
+
+    return 0;
+}
+
+
+/* Same as make_prn_compact(), but with the 32-bit SP arrays */
+int make_prn_table(desprng_table_t *table_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn)
+{
+    _destab(table_data, compact_data, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return 0;
+}
+
+
+/* Same as get_uniform_prn_compact(), but with the 32-bit SP arrays */
+double get_uniform_prn_table(desprng_table_t *table_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn)
+{
+    _destab(table_data, compact_data, (unsigned char *)&icount, (unsigned char *)iprn);
 
     return *iprn / (1.0 + ULONG_MAX);
 }
 
+
+/* Same as make_prn_table(), but with the paired SP arrays */
+int make_prn_paired(desprng_pairtable_t *pairtable_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn)
+{
+    _despair(pairtable_data, compact_data, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return 0;
+}
+
+
+/* Same as get_uniform_prn_table(), but with the paired SP arrays */
+double get_uniform_prn_paired(desprng_pairtable_t *pairtable_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn)
+{
+    _despair(pairtable_data, compact_data, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+/* Same as make_prn(), but with the subkeys derived from the identifier nident
+   on the fly, so that no desprng_individual_t is needed. Slower per PRN, but the
+   per-particle state is just the eight bytes of nident */
+int make_prn_ident(desprng_common_t *process_data, unsigned long nident, unsigned long icount, unsigned long *iprn)
+{
+    _desident(process_data, (unsigned char *)&nident, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return 0;
+}
+
+
+/* Same as get_uniform_prn(), but with the subkeys derived on the fly */
+double get_uniform_prn_ident(desprng_common_t *process_data, unsigned long nident, unsigned long icount, unsigned long *iprn)
+{
+    _desident(process_data, (unsigned char *)&nident, (unsigned char *)&icount, (unsigned char *)iprn);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+/* Computes an unsigned long PRN with version 1 of the PRNG-only variant,
+   which skips the DES initial and final permutations (see _deswordnp1() in
+   des.c). The PRNs are different from those of make_prn() */
+int make_prn_np1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _deswordnp1(process_data, thread_data, icount);
+
+    return 0;
+}
+
+
+/* Same as get_uniform_prn(), but with the PRN of make_prn_np1() */
+double get_uniform_prn_np1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn)
+{
+    *iprn = _deswordnp1(process_data, thread_data, icount);
+
+    return *iprn / (1.0 + ULONG_MAX);
+}
+
+
+/* Same as make_prn_range(), but with the PRNs of make_prn_np1() */
+int make_prn_range_np1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, unsigned long *iprn)
+{
+    unsigned long i;
+
+    for (i = 0UL; i < n; i++) iprn[i] = _deswordnp1(process_data, thread_data, icount_start + i);
+
+    return 0;
+}
+
+
+/* Computes the n unsigned long PRNs for the consecutive counters
+   icount_start, icount_start + 1, ..., icount_start + n - 1 */
+int make_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, unsigned long *iprn)
+{
+    _desrange(process_data, thread_data, icount_start, n, iprn);
+
+    return 0;
+}
+
+
+/* Same as make_prn_range(), but returns the PRNs in the form of double-precision floats,
+   uniform in the range [0, 1), as get_uniform_prn() does */
+int get_uniform_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, double *xprn)
+{
+    unsigned long iprn[64], i, j, m;
+
+    /* Go through the range in pieces that fit in L1 cache */
+    for (i = 0UL; i < n; i += m)
+    {
+        m = n - i < 64UL ? n - i : 64UL;
+        _desrange(process_data, thread_data, icount_start + i, m, iprn);
+        for (j = 0UL; j < m; j++) xprn[i + j] = iprn[j] / (1.0 + ULONG_MAX);
+    }
+
+    return 0;
+}
+
 /* Initializes the read-only DES PRNG data used by all threads */
 int initialize_common(desprng_common_t *process_data)
 {
@@ -303,6 +598,8 @@ int initialize_common(desprng_common_t *process_data)
 /* Hopefully self explanatory... */
 int check_type_sizes()
 {
+    if (!(UINT_MAX == 4294967295U)) /* Verify that unsigned int is 4 bytes */
+        return -4;
     if (!(ULONG_MAX == 18446744073709551615UL)) /* Verify that unsigned long is 8 bytes */
         return -3;
     if (!(USHRT_MAX == 65535)) /* Verify that unsigned short is 2 bytes */
@@ -312,3 +609,147 @@ int check_type_sizes()
 
     return 0;
 }
+
+
+/* Box-Muller transform of one PRN into two independent normal PRNs, using the
+   high 32 bits as the uniform in (0, 1] for the radius and the low 32 bits
+   as the uniform in [0, 1) for the angle. The largest magnitude is about 6.66 */
+static void _boxmuller(unsigned long iprn, double *xnormal)
+{
+    double r, phi;
+
+    r = sqrt(-2.0 * log(((iprn >> 32) + 1.0) * DESPRNG_TWOM32));
+    phi = (iprn & 0xffffffffUL) * DESPRNG_TWOPITWOM32;
+    xnormal[0] = r * cos(phi);
+    xnormal[1] = r * sin(phi);
+
+    return;
+}
+
+
+/* Computes the PRN for icount, as make_prn() does, and turns it into two
+   normally distributed (zero mean, unit variance) PRNs xnormal[0] and xnormal[1] */
+int get_normal_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn, double *xnormal)
+{
+    *iprn = _desword(process_data, thread_data, icount);
+    _boxmuller(*iprn, xnormal);
+
+    return 0;
+}
+
+
+/* Same as get_normal_prn() for the n consecutive counters icount_start, ...,
+   icount_start + n - 1. The pair from counter icount_start + i is stored in
+   xnormal[2 * i] and xnormal[2 * i + 1], so xnormal must hold 2 * n doubles */
+int get_normal_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, double *xnormal)
+{
+    unsigned long iprn[64], i, j, m;
+
+    for (i = 0UL; i < n; i += m)
+    {
+        m = n - i < 64UL ? n - i : 64UL;
+        _desrange(process_data, thread_data, icount_start + i, m, iprn);
+        /* With OpenMP SIMD (and e.g. glibc's libmvec), log, sqrt, cos and sin are vectorized */
+        #pragma omp simd
+        for (j = 0UL; j < m; j++) _boxmuller(iprn[j], xnormal + 2 * (i + j));
+    }
+
+    return 0;
+}
+
+
+/* Turns the 53 most significant bits of iprn into a double in [0, 1), (0, 1]
+   or (0, 1), depending on orbit and add (see _interval53()). The integer is
+   less than 2**53, so it converts to double exactly (and as a signed long,
+   which vectorizes better), and the scaling by 2**-53 is exact too */
+static double _todouble53(unsigned long iprn, unsigned long orbit, unsigned long add)
+{
+    return (long)(((iprn >> 11) | orbit) + add) * DESPRNG_TWOM53;
+}
+
+
+/* The orbit and add of _todouble53() for the interval: [0, 1) uses k, (0, 1]
+   uses k + 1, and (0, 1) uses the odd k | 1, which keeps 52 random bits, but
+   is symmetric about one half. Returns -1 for an unknown interval */
+static int _interval53(int interval, unsigned long *orbit, unsigned long *add)
+{
+    switch (interval)
+    {
+    case DESPRNG_CLOSED_OPEN: *orbit = 0UL; *add = 0UL; return 0;
+    case DESPRNG_OPEN_CLOSED: *orbit = 0UL; *add = 1UL; return 0;
+    case DESPRNG_OPEN_OPEN:   *orbit = 1UL; *add = 0UL; return 0;
+    }
+
+    return -1;
+}
+
+
+/* Same as get_uniform_prn(), but with 53 random bits and without a divide.
+   Unlike get_uniform_prn(), which can round up to exactly 1.0, the result is
+   always in the requested interval: DESPRNG_CLOSED_OPEN for [0, 1),
+   DESPRNG_OPEN_CLOSED for (0, 1] or DESPRNG_OPEN_OPEN for (0, 1). An unknown
+   interval gives -1.0 */
+double get_uniform53_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, int interval, unsigned long *iprn)
+{
+    unsigned long orbit, add;
+
+    if (_interval53(interval, &orbit, &add)) return -1.0;
+    *iprn = _desword(process_data, thread_data, icount);
+
+    return _todouble53(*iprn, orbit, add);
+}
+
+
+/* Same as get_uniform53_prn() for the n consecutive counters icount_start, ...,
+   icount_start + n - 1. Returns -1 for an unknown interval */
+int get_uniform53_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, int interval, double *xprn)
+{
+    unsigned long iprn[64], i, j, m, orbit, add;
+
+    if (_interval53(interval, &orbit, &add)) return -1;
+    for (i = 0UL; i < n; i += m)
+    {
+        m = n - i < 64UL ? n - i : 64UL;
+        _desrange(process_data, thread_data, icount_start + i, m, iprn);
+        #pragma omp simd
+        for (j = 0UL; j < m; j++) xprn[i + j] = _todouble53(iprn[j], orbit, add);
+    }
+
+    return 0;
+}
+
+
+/* Computes the PRN for icount, as make_prn() does, and turns each of its
+   32-bit halves into a float in [0, 1) with 24 random bits, high half first */
+int get_uniform_float_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn, float *xprn)
+{
+    *iprn = _desword(process_data, thread_data, icount);
+    xprn[0] = (int)(*iprn >> 40) * DESPRNG_TWOM24;
+    xprn[1] = (int)((*iprn >> 8) & 0xffffffUL) * DESPRNG_TWOM24;
+
+    return 0;
+}
+
+
+/* Same as get_uniform_float_prn() for the n consecutive counters
+   icount_start, ..., icount_start + n - 1. The floats from counter
+   icount_start + i are xprn[2 * i] and xprn[2 * i + 1], so xprn must hold
+   2 * n floats */
+int get_uniform_float_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, float *xprn)
+{
+    unsigned long iprn[64], i, j, m;
+
+    for (i = 0UL; i < n; i += m)
+    {
+        m = n - i < 64UL ? n - i : 64UL;
+        _desrange(process_data, thread_data, icount_start + i, m, iprn);
+        #pragma omp simd
+        for (j = 0UL; j < m; j++)
+        {
+            xprn[2 * (i + j)] = (int)(iprn[j] >> 40) * DESPRNG_TWOM24;
+            xprn[2 * (i + j) + 1] = (int)((iprn[j] >> 8) & 0xffffffUL) * DESPRNG_TWOM24;
+        }
+    }
+
+    return 0;
+}
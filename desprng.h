@@ -13,19 +13,54 @@
  * Author: Johan Carlsson
 */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* Data structure that each thread needs a private copy of */
 typedef struct desprng_thread_variables
 {
     /* This is the unique PRNG identifier */
     unsigned long nident;
     /* These three arrays are expanded versions of the indentifier.
-       They are not striclty necessary, but allow for faster PRN generation. */
+       They are not striclty necessary, but allow for faster PRN generation.
+       Only KnL is used (KnR and Kn3 are left as they are). */
     unsigned long KnL[32];
     unsigned long KnR[32];
     unsigned long Kn3[32];
 }
 desprng_individual_t;
 
+/* Compact alternative to desprng_individual_t (136 vs. 776 bytes), with the
+   same output. Only KnL is used by DES, and its subkeys fit in 32 bits */
+typedef struct desprng_thread_compact_variables
+{
+    /* This is the unique PRNG identifier */
+    unsigned long nident;
+    /* The expanded identifier (16 pairs of 32-bit subkeys) */
+    unsigned KnL[32];
+}
+desprng_compact_t;
+
+/* The next free counter of an identifier (or of a block of identifiers), for
+   reserving counter ranges with desprng_reserve() */
+typedef struct desprng_counter_variables
+{
+    unsigned long next;
+}
+desprng_counter_t;
+
+/* The NUMA nodes (with CPUs) of a machine, and a copy of desprng_common_t on
+   each, set up by desprng_numa_init() */
+typedef struct desprng_numa_variables
+{
+    int nnode;
+    int ncpu; /* Number of entries in node_of_cpu (the highest CPU number + 1) */
+    int *node_of_cpu; /* -1 for CPUs that are not online */
+    struct desprng_process_variables **common; /* One per node */
+}
+desprng_numa_t;
+
 /* Read-only data structure accessed by all threads */
 typedef struct desprng_process_variables
 {
@@ -38,6 +73,30 @@ typedef struct desprng_process_variables
 }
 desprng_common_t;
 
+/* The SP arrays of desprng_common_t, which are all that DES reads after the
+   key schedule, with 32-bit entries (2 kB instead of 8 kB). The struct is
+   aligned on a 64-byte cache line (with GCC and compatible compilers) */
+typedef struct desprng_process_table
+{
+    unsigned SP[8][64];
+}
+#ifdef __GNUC__
+__attribute__ ((aligned (64)))
+#endif
+desprng_table_t;
+
+/* The SP arrays of desprng_common_t merged in pairs, for the two S-boxes that
+   each 12 bits of a DES round look up (64 kB instead of 2 kB). A round then
+   takes four table lookups instead of eight. Aligned like desprng_table_t */
+typedef struct desprng_process_pairtable
+{
+    unsigned SP[4][4096];
+}
+#ifdef __GNUC__
+__attribute__ ((aligned (64)))
+#endif
+desprng_pairtable_t;
+
 /* Signatures for the user interface */
 
 #pragma acc routine(initialize_common) seq
@@ -49,10 +108,146 @@ int create_identifier(unsigned long *nident);
 #pragma acc routine(initialize_individual) seq
 int initialize_individual(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long nident);
 
+int initialize_individuals(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long *nparticle, unsigned long n);
+
 #pragma acc routine(make_prn) seq
 int make_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
 
+#pragma acc routine(make_prn_word) seq
+unsigned long make_prn_word(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount);
+
 #pragma acc routine(get_uniform_prn) seq
 double get_uniform_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
 
+#pragma acc routine(make_prn_range) seq
+int make_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, unsigned long *iprn);
+
+#pragma acc routine(get_uniform_prn_range) seq
+int get_uniform_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, double *xprn);
+
 int check_type_sizes();
+
+/* The user interface for the compact state */
+
+#pragma acc routine(initialize_compact) seq
+int initialize_compact(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned long nident);
+
+#pragma acc routine(make_prn_compact) seq
+int make_prn_compact(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn);
+
+#pragma acc routine(get_uniform_prn_compact) seq
+double get_uniform_prn_compact(desprng_common_t *process_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn);
+
+/* The user interface for the compact state and the 32-bit SP arrays.
+   desprng_common_t is still needed by initialize_compact() */
+
+int initialize_table(desprng_common_t *process_data, desprng_table_t *table_data);
+
+#pragma acc routine(make_prn_table) seq
+int make_prn_table(desprng_table_t *table_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn);
+
+#pragma acc routine(get_uniform_prn_table) seq
+double get_uniform_prn_table(desprng_table_t *table_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn);
+
+/* Same as the table functions, but with the paired SP arrays */
+
+int initialize_pairtable(desprng_common_t *process_data, desprng_pairtable_t *pairtable_data);
+
+#pragma acc routine(make_prn_paired) seq
+int make_prn_paired(desprng_pairtable_t *pairtable_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn);
+
+#pragma acc routine(get_uniform_prn_paired) seq
+double get_uniform_prn_paired(desprng_pairtable_t *pairtable_data, desprng_compact_t *compact_data, unsigned long icount, unsigned long *iprn);
+
+/* Reduced-round (8, 10 and 12 of the 16 DES rounds) tiers of make_prn() and
+   get_uniform_prn(), faster but with different PRNs, not yet tested with Crush */
+#pragma acc routine(make_prn8) seq
+int make_prn8(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(make_prn10) seq
+int make_prn10(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(make_prn12) seq
+int make_prn12(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(get_uniform_prn8) seq
+double get_uniform_prn8(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(get_uniform_prn10) seq
+double get_uniform_prn10(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(get_uniform_prn12) seq
+double get_uniform_prn12(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+
+/* Two normally distributed PRNs per counter, from a Box-Muller transform */
+#pragma acc routine(get_normal_prn) seq
+int get_normal_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn, double *xnormal);
+int get_normal_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, double *xnormal);
+
+/* Uniform PRNs without a divide: 53-bit doubles in the interval given by one
+   of the constants below, and two 24-bit floats in [0, 1) per counter */
+#define DESPRNG_CLOSED_OPEN 0
+#define DESPRNG_OPEN_CLOSED 1
+#define DESPRNG_OPEN_OPEN 2
+#pragma acc routine(get_uniform53_prn) seq
+double get_uniform53_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, int interval, unsigned long *iprn);
+int get_uniform53_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, int interval, double *xprn);
+#pragma acc routine(get_uniform_float_prn) seq
+int get_uniform_float_prn(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn, float *xprn);
+int get_uniform_float_prn_range(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, float *xprn);
+
+/* Version 1 of the PRNG-only variant, which is DES without the initial and
+   final permutations. It gives other PRNs than make_prn(), which are the same
+   on any byte order, and the known answers in oldnewcomparison.c. A change to
+   it would be a new variant (np2), never a change to np1 */
+#define DESPRNG_NP_VERSION 1
+#pragma acc routine(make_prn_np1) seq
+int make_prn_np1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(get_uniform_prn_np1) seq
+double get_uniform_prn_np1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(make_prn_range_np1) seq
+int make_prn_range_np1(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, unsigned long *iprn);
+
+/* Subkeys derived on the fly from nident, so the per-particle state is only the identifier */
+#pragma acc routine(make_prn_ident) seq
+int make_prn_ident(desprng_common_t *process_data, unsigned long nident, unsigned long icount, unsigned long *iprn);
+#pragma acc routine(get_uniform_prn_ident) seq
+double get_uniform_prn_ident(desprng_common_t *process_data, unsigned long nident, unsigned long icount, unsigned long *iprn);
+
+/* Bitsliced backend (CPU only) that computes n PRNs at once, one for each
+   (nident[i], icount[i]) pair, with the same output as make_prn() */
+int make_prn_bitsliced(desprng_common_t *process_data, unsigned long n, unsigned long *nident, unsigned long *icount, unsigned long *iprn);
+
+/* SIMD backend (CPU only) that computes n PRNs at once, one for each
+   (thread_data[i], icount[i]) pair, with the same output as make_prn().
+   AVX2 or AVX-512 is used if the CPU has it, as reported by get_simd_lanes() */
+int make_prn_simd(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long n, unsigned long *icount, unsigned long *iprn);
+
+int get_simd_lanes();
+
+/* Buffer fills (CPU only) with one PRN per stream, out[i] for states[i] and
+   the common counter icount, the same as make_prn() and get_uniform_prn() give.
+   Large buffers are written with non-temporal stores */
+int desprng_fill_u64(desprng_common_t *process_data, desprng_individual_t *states, unsigned long n_streams, unsigned long icount, unsigned long *out);
+int desprng_fill_double(desprng_common_t *process_data, desprng_individual_t *states, unsigned long n_streams, unsigned long icount, double *out);
+
+/* Key-schedule cache files (CPU only), with the state of a population of
+   particles with consecutive particle numbers. A file is written once, then
+   mapped read-only (and shared by the processes on a node) on later runs */
+#define DESPRNG_LAYOUT_INDIVIDUAL 1 /* An array of desprng_individual_t */
+#define DESPRNG_LAYOUT_COMPACT 2 /* An array of desprng_compact_t */
+int desprng_write_schedules(const char *filename, int layout, const void *data, unsigned long n, unsigned long nparticle_first);
+int desprng_map_schedules(const char *filename, int layout, void **data, unsigned long *n, unsigned long *nparticle_first);
+int desprng_unmap_schedules(void *data);
+
+/* Lock-free reservation of disjoint counter ranges (CPU only) */
+int desprng_counter_init(desprng_counter_t *counter, unsigned long icount_start);
+int desprng_reserve(desprng_counter_t *counter, unsigned long n, unsigned long *icount_start);
+unsigned long desprng_counter_left(desprng_counter_t *counter);
+
+/* NUMA placement (CPU only, Linux): a copy of desprng_common_t per node, and
+   arrays of desprng_individual_t that are first touched on the nodes in turn */
+int desprng_numa_init(desprng_numa_t *numa);
+int desprng_numa_node(desprng_numa_t *numa);
+desprng_common_t *desprng_numa_common(desprng_numa_t *numa);
+desprng_individual_t *desprng_numa_individuals(desprng_numa_t *numa, unsigned long n);
+void desprng_numa_free(desprng_numa_t *numa);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,430 @@
+/* This is the header-only C++ version of the libdesprng library.
+ * desprng::engine produces the same PRNs as make_prn() for the same
+ * identifier and counter, but needs neither libdesprng.a nor
+ * initialize_common(): the tables are constexpr data, and the whole cipher
+ * is inlined into the caller, with the subkeys in the engine itself.
+ *
+ * The engine is a UniformRandomBitGenerator, so it works with the
+ * distributions in <random>. Since it is counter based, the PRN for a given
+ * counter can also be computed with the const operator()(icount), which is
+ * what parallel algorithms (e.g. std::transform with std::execution::par)
+ * should use, rather than sharing the internal counter between threads.
+ *
+ * The number of DES rounds is a template parameter of desprng::basic_engine.
+ *
+ * Requires C++17. See the source files for copyright and license information.
+ *
+ * Author: Johan Carlsson
+*/
+
+#ifndef DESPRNG_HPP
+#define DESPRNG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace desprng
+{
+
+namespace detail
+{
+
+/* The eight arrays that are read by the round function, as in initialize_common() */
+inline constexpr std::uint32_t SP[8][64] =
+{
+    {
+        0x01010400u, 0x00000000u, 0x00010000u, 0x01010404u,
+        0x01010004u, 0x00010404u, 0x00000004u, 0x00010000u,
+        0x00000400u, 0x01010400u, 0x01010404u, 0x00000400u,
+        0x01000404u, 0x01010004u, 0x01000000u, 0x00000004u,
+        0x00000404u, 0x01000400u, 0x01000400u, 0x00010400u,
+        0x00010400u, 0x01010000u, 0x01010000u, 0x01000404u,
+        0x00010004u, 0x01000004u, 0x01000004u, 0x00010004u,
+        0x00000000u, 0x00000404u, 0x00010404u, 0x01000000u,
+        0x00010000u, 0x01010404u, 0x00000004u, 0x01010000u,
+        0x01010400u, 0x01000000u, 0x01000000u, 0x00000400u,
+        0x01010004u, 0x00010000u, 0x00010400u, 0x01000004u,
+        0x00000400u, 0x00000004u, 0x01000404u, 0x00010404u,
+        0x01010404u, 0x00010004u, 0x01010000u, 0x01000404u,
+        0x01000004u, 0x00000404u, 0x00010404u, 0x01010400u,
+        0x00000404u, 0x01000400u, 0x01000400u, 0x00000000u,
+        0x00010004u, 0x00010400u, 0x00000000u, 0x01010004u
+    },
+    {
+        0x80108020u, 0x80008000u, 0x00008000u, 0x00108020u,
+        0x00100000u, 0x00000020u, 0x80100020u, 0x80008020u,
+        0x80000020u, 0x80108020u, 0x80108000u, 0x80000000u,
+        0x80008000u, 0x00100000u, 0x00000020u, 0x80100020u,
+        0x00108000u, 0x00100020u, 0x80008020u, 0x00000000u,
+        0x80000000u, 0x00008000u, 0x00108020u, 0x80100000u,
+        0x00100020u, 0x80000020u, 0x00000000u, 0x00108000u,
+        0x00008020u, 0x80108000u, 0x80100000u, 0x00008020u,
+        0x00000000u, 0x00108020u, 0x80100020u, 0x00100000u,
+        0x80008020u, 0x80100000u, 0x80108000u, 0x00008000u,
+        0x80100000u, 0x80008000u, 0x00000020u, 0x80108020u,
+        0x00108020u, 0x00000020u, 0x00008000u, 0x80000000u,
+        0x00008020u, 0x80108000u, 0x00100000u, 0x80000020u,
+        0x00100020u, 0x80008020u, 0x80000020u, 0x00100020u,
+        0x00108000u, 0x00000000u, 0x80008000u, 0x00008020u,
+        0x80000000u, 0x80100020u, 0x80108020u, 0x00108000u
+    },
+    {
+        0x00000208u, 0x08020200u, 0x00000000u, 0x08020008u,
+        0x08000200u, 0x00000000u, 0x00020208u, 0x08000200u,
+        0x00020008u, 0x08000008u, 0x08000008u, 0x00020000u,
+        0x08020208u, 0x00020008u, 0x08020000u, 0x00000208u,
+        0x08000000u, 0x00000008u, 0x08020200u, 0x00000200u,
+        0x00020200u, 0x08020000u, 0x08020008u, 0x00020208u,
+        0x08000208u, 0x00020200u, 0x00020000u, 0x08000208u,
+        0x00000008u, 0x08020208u, 0x00000200u, 0x08000000u,
+        0x08020200u, 0x08000000u, 0x00020008u, 0x00000208u,
+        0x00020000u, 0x08020200u, 0x08000200u, 0x00000000u,
+        0x00000200u, 0x00020008u, 0x08020208u, 0x08000200u,
+        0x08000008u, 0x00000200u, 0x00000000u, 0x08020008u,
+        0x08000208u, 0x00020000u, 0x08000000u, 0x08020208u,
+        0x00000008u, 0x00020208u, 0x00020200u, 0x08000008u,
+        0x08020000u, 0x08000208u, 0x00000208u, 0x08020000u,
+        0x00020208u, 0x00000008u, 0x08020008u, 0x00020200u
+    },
+    {
+        0x00802001u, 0x00002081u, 0x00002081u, 0x00000080u,
+        0x00802080u, 0x00800081u, 0x00800001u, 0x00002001u,
+        0x00000000u, 0x00802000u, 0x00802000u, 0x00802081u,
+        0x00000081u, 0x00000000u, 0x00800080u, 0x00800001u,
+        0x00000001u, 0x00002000u, 0x00800000u, 0x00802001u,
+        0x00000080u, 0x00800000u, 0x00002001u, 0x00002080u,
+        0x00800081u, 0x00000001u, 0x00002080u, 0x00800080u,
+        0x00002000u, 0x00802080u, 0x00802081u, 0x00000081u,
+        0x00800080u, 0x00800001u, 0x00802000u, 0x00802081u,
+        0x00000081u, 0x00000000u, 0x00000000u, 0x00802000u,
+        0x00002080u, 0x00800080u, 0x00800081u, 0x00000001u,
+        0x00802001u, 0x00002081u, 0x00002081u, 0x00000080u,
+        0x00802081u, 0x00000081u, 0x00000001u, 0x00002000u,
+        0x00800001u, 0x00002001u, 0x00802080u, 0x00800081u,
+        0x00002001u, 0x00002080u, 0x00800000u, 0x00802001u,
+        0x00000080u, 0x00800000u, 0x00002000u, 0x00802080u
+    },
+    {
+        0x00000100u, 0x02080100u, 0x02080000u, 0x42000100u,
+        0x00080000u, 0x00000100u, 0x40000000u, 0x02080000u,
+        0x40080100u, 0x00080000u, 0x02000100u, 0x40080100u,
+        0x42000100u, 0x42080000u, 0x00080100u, 0x40000000u,
+        0x02000000u, 0x40080000u, 0x40080000u, 0x00000000u,
+        0x40000100u, 0x42080100u, 0x42080100u, 0x02000100u,
+        0x42080000u, 0x40000100u, 0x00000000u, 0x42000000u,
+        0x02080100u, 0x02000000u, 0x42000000u, 0x00080100u,
+        0x00080000u, 0x42000100u, 0x00000100u, 0x02000000u,
+        0x40000000u, 0x02080000u, 0x42000100u, 0x40080100u,
+        0x02000100u, 0x40000000u, 0x42080000u, 0x02080100u,
+        0x40080100u, 0x00000100u, 0x02000000u, 0x42080000u,
+        0x42080100u, 0x00080100u, 0x42000000u, 0x42080100u,
+        0x02080000u, 0x00000000u, 0x40080000u, 0x42000000u,
+        0x00080100u, 0x02000100u, 0x40000100u, 0x00080000u,
+        0x00000000u, 0x40080000u, 0x02080100u, 0x40000100u
+    },
+    {
+        0x20000010u, 0x20400000u, 0x00004000u, 0x20404010u,
+        0x20400000u, 0x00000010u, 0x20404010u, 0x00400000u,
+        0x20004000u, 0x00404010u, 0x00400000u, 0x20000010u,
+        0x00400010u, 0x20004000u, 0x20000000u, 0x00004010u,
+        0x00000000u, 0x00400010u, 0x20004010u, 0x00004000u,
+        0x00404000u, 0x20004010u, 0x00000010u, 0x20400010u,
+        0x20400010u, 0x00000000u, 0x00404010u, 0x20404000u,
+        0x00004010u, 0x00404000u, 0x20404000u, 0x20000000u,
+        0x20004000u, 0x00000010u, 0x20400010u, 0x00404000u,
+        0x20404010u, 0x00400000u, 0x00004010u, 0x20000010u,
+        0x00400000u, 0x20004000u, 0x20000000u, 0x00004010u,
+        0x20000010u, 0x20404010u, 0x00404000u, 0x20400000u,
+        0x00404010u, 0x20404000u, 0x00000000u, 0x20400010u,
+        0x00000010u, 0x00004000u, 0x20400000u, 0x00404010u,
+        0x00004000u, 0x00400010u, 0x20004010u, 0x00000000u,
+        0x20404000u, 0x20000000u, 0x00400010u, 0x20004010u
+    },
+    {
+        0x00200000u, 0x04200002u, 0x04000802u, 0x00000000u,
+        0x00000800u, 0x04000802u, 0x00200802u, 0x04200800u,
+        0x04200802u, 0x00200000u, 0x00000000u, 0x04000002u,
+        0x00000002u, 0x04000000u, 0x04200002u, 0x00000802u,
+        0x04000800u, 0x00200802u, 0x00200002u, 0x04000800u,
+        0x04000002u, 0x04200000u, 0x04200800u, 0x00200002u,
+        0x04200000u, 0x00000800u, 0x00000802u, 0x04200802u,
+        0x00200800u, 0x00000002u, 0x04000000u, 0x00200800u,
+        0x04000000u, 0x00200800u, 0x00200000u, 0x04000802u,
+        0x04000802u, 0x04200002u, 0x04200002u, 0x00000002u,
+        0x00200002u, 0x04000000u, 0x04000800u, 0x00200000u,
+        0x04200800u, 0x00000802u, 0x00200802u, 0x04200800u,
+        0x00000802u, 0x04000002u, 0x04200802u, 0x04200000u,
+        0x00200800u, 0x00000000u, 0x00000002u, 0x04200802u,
+        0x00000000u, 0x00200802u, 0x04200000u, 0x00000800u,
+        0x04000002u, 0x04000800u, 0x00000800u, 0x00200002u
+    },
+    {
+        0x10001040u, 0x00001000u, 0x00040000u, 0x10041040u,
+        0x10000000u, 0x10001040u, 0x00000040u, 0x10000000u,
+        0x00040040u, 0x10040000u, 0x10041040u, 0x00041000u,
+        0x10041000u, 0x00041040u, 0x00001000u, 0x00000040u,
+        0x10040000u, 0x10000040u, 0x10001000u, 0x00001040u,
+        0x00041000u, 0x00040040u, 0x10040040u, 0x10041000u,
+        0x00001040u, 0x00000000u, 0x00000000u, 0x10040040u,
+        0x10000040u, 0x10001000u, 0x00041040u, 0x00040000u,
+        0x00041040u, 0x00040000u, 0x10041000u, 0x00001000u,
+        0x00000040u, 0x10040040u, 0x00001000u, 0x00041040u,
+        0x10001000u, 0x00000040u, 0x10000040u, 0x10040000u,
+        0x10040040u, 0x10000000u, 0x00040000u, 0x10001040u,
+        0x00000000u, 0x10041040u, 0x00040040u, 0x10000040u,
+        0x10040000u, 0x10001000u, 0x10001040u, 0x00000000u,
+        0x10041040u, 0x00041000u, 0x00041000u, 0x00001040u,
+        0x00001040u, 0x00040040u, 0x10000000u, 0x10041000u
+    }
+};
+
+/* The tables of the fast key schedule in des.c (_PC1 and _PC2 there), made at compile time */
+struct keytables
+{
+    /* C << 28 | D for each nibble of the key */
+    std::uint64_t PC1[16][16];
+    /* Cooked subkey pair KnL[2i] << 32 | KnL[2i + 1] for each seven bits of C and D */
+    std::uint64_t PC2[8][128];
+    /* Rotation of C and D before each round */
+    unsigned char shift[16];
+};
+
+constexpr keytables make_keytables()
+{
+    constexpr unsigned char pc1[56] =
+    {
+        56, 48, 40, 32, 24, 16,  8,  0, 57, 49, 41, 33, 25, 17,
+         9,  1, 58, 50, 42, 34, 26, 18, 10,  2, 59, 51, 43, 35,
+        62, 54, 46, 38, 30, 22, 14,  6, 61, 53, 45, 37, 29, 21,
+        13,  5, 60, 52, 44, 36, 28, 20, 12,  4, 27, 19, 11,  3
+    };
+    constexpr unsigned char pc2[48] =
+    {
+        13, 16, 10, 23,  0,  4,  2, 27, 14,  5, 20,  9,
+        22, 18, 11,  3, 25,  7, 15,  6, 26, 19, 12,  1,
+        40, 51, 30, 36, 46, 54, 29, 39, 50, 44, 32, 47,
+        43, 48, 38, 55, 33, 52, 45, 41, 49, 35, 28, 31
+    };
+    constexpr unsigned char totrot[16] =
+        {1, 2, 4, 6, 8, 10, 12, 14, 15, 17, 19, 21, 23, 25, 27, 28};
+
+    keytables t{};
+    int b = 0, i = 0, j = 0, v = 0;
+
+    for (b = 0; b < 16; b++)
+        for (v = 0; v < 16; v++)
+            for (j = 0; j < 56; j++)
+                if (pc1[j] >> 3 == b >> 1 && ((b & 1) ? v : v << 4) & (0200 >> (pc1[j] & 07)))
+                    t.PC1[b][v] |= std::uint64_t(1) << (55 - j);
+
+    for (b = 0; b < 8; b++)
+        for (v = 0; v < 128; v++)
+        {
+            std::uint64_t cd = std::uint64_t(v) << (21 - 7 * (b & 3)), raw0 = 0, raw1 = 0, cook0 = 0, cook1 = 0;
+
+            for (j = 0; j < 24; j++)
+            {
+                if (b < 4 && (cd >> (27 - pc2[j])) & 1) raw0 |= 0x800000 >> j;
+                if (b >= 4 && (cd >> (55 - pc2[j + 24])) & 1) raw1 |= 0x800000 >> j;
+            }
+            /* _cookey() of the first pair */
+            cook0 = (raw0 & 0x00fc0000) << 6 | (raw0 & 0x00000fc0) << 10 | (raw1 & 0x00fc0000) >> 10 | (raw1 & 0x00000fc0) >> 6;
+            cook1 = (raw0 & 0x0003f000) << 12 | (raw0 & 0x0000003f) << 16 | (raw1 & 0x0003f000) >> 4 | (raw1 & 0x0000003f);
+            t.PC2[b][v] = cook0 << 32 | cook1;
+        }
+
+    for (i = 0; i < 16; i++) t.shift[i] = totrot[i] - (i ? totrot[i - 1] : 0);
+
+    return t;
+}
+
+inline constexpr keytables KT = make_keytables();
+
+/* The cipher function f of one DES round, as _desf() */
+inline std::uint32_t desf(std::uint32_t right, std::uint32_t key0, std::uint32_t key1) noexcept
+{
+    std::uint32_t fval, work;
+
+    work  = (right << 28) | (right >> 4);
+    work ^= key0;
+    fval  = SP[6][ work        & 0x3f];
+    fval |= SP[4][(work >>  8) & 0x3f];
+    fval |= SP[2][(work >> 16) & 0x3f];
+    fval |= SP[0][(work >> 24) & 0x3f];
+    work  = right ^ key1;
+    fval |= SP[7][ work        & 0x3f];
+    fval |= SP[5][(work >>  8) & 0x3f];
+    fval |= SP[3][(work >> 16) & 0x3f];
+    fval |= SP[1][(work >> 24) & 0x3f];
+
+    return fval;
+}
+
+} // namespace detail
+
+
+/* Rounds is the number of DES rounds: 16 (the default) gives the same PRNs as
+   make_prn(), and 8, 10 and 12 the same as make_prn8(), make_prn10() and
+   make_prn12() */
+template <int Rounds = 16>
+class basic_engine
+{
+    static_assert(Rounds >= 2 && Rounds <= 16 && Rounds % 2 == 0, "Rounds must be even and at most 16");
+
+public:
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    /* Turns a number < 2**56 (e.g. the particle number) into an identifier,
+       as create_identifier() does. Returns false if the number is too large */
+    static constexpr bool create_identifier(std::uint64_t &nident) noexcept
+    {
+        std::uint64_t ntmp = nident << 1;
+
+        if (nident >> 56) return false;
+        nident = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            ntmp <<= 7;
+            nident += (ntmp >> 57) << ((7 - i) * 8 + 1);
+        }
+        return true;
+    }
+
+    /* Binds the engine to the identifier nident (from create_identifier()),
+       as initialize_individual() does, and sets the counter to icount */
+    explicit basic_engine(std::uint64_t nident = 0, std::uint64_t icount = 0) noexcept
+    {
+        seed(nident);
+        seek(icount);
+    }
+
+    void seed(std::uint64_t nident) noexcept
+    {
+        unsigned char key[8];
+        std::uint64_t cd = 0, c, d, pair;
+        int i;
+
+        this->nident = nident;
+        std::memcpy(key, &nident, 8);
+        for (i = 0; i < 8; i++)
+            cd |= detail::KT.PC1[i << 1][key[i] >> 4] | detail::KT.PC1[(i << 1) + 1][key[i] & 0xf];
+        c = cd >> 28;
+        d = cd & 0xfffffff;
+        for (i = 0; i < 16; i++)
+        {
+            c = ((c << detail::KT.shift[i]) | (c >> (28 - detail::KT.shift[i]))) & 0xfffffff;
+            d = ((d << detail::KT.shift[i]) | (d >> (28 - detail::KT.shift[i]))) & 0xfffffff;
+            pair  = detail::KT.PC2[0][ c >> 21        ] | detail::KT.PC2[4][ d >> 21        ];
+            pair |= detail::KT.PC2[1][(c >> 14) & 0x7f] | detail::KT.PC2[5][(d >> 14) & 0x7f];
+            pair |= detail::KT.PC2[2][(c >>  7) & 0x7f] | detail::KT.PC2[6][(d >>  7) & 0x7f];
+            pair |= detail::KT.PC2[3][ c        & 0x7f] | detail::KT.PC2[7][ d        & 0x7f];
+            KnL[i << 1] = std::uint32_t(pair >> 32);
+            KnL[(i << 1) + 1] = std::uint32_t(pair);
+        }
+    }
+
+    /* The counter that the next call to operator()() uses */
+    void seek(std::uint64_t icount) noexcept { this->icount = icount; }
+    std::uint64_t tell() const noexcept { return icount; }
+    void discard(unsigned long long z) noexcept { icount += z; }
+
+    std::uint64_t identifier() const noexcept { return nident; }
+
+    /* The PRN for the current counter, which is then advanced */
+    result_type operator()() noexcept { return (*this)(icount++); }
+
+    /* The PRN for the counter icount, the same as make_prn() gives */
+    result_type operator()(std::uint64_t icount) const noexcept
+    {
+        unsigned char block[8];
+        std::uint32_t leftt, right, work;
+        std::uint64_t iprn;
+        int round;
+
+        /* _scrunch() */
+        std::memcpy(block, &icount, 8);
+        leftt = std::uint32_t(block[0]) << 24 | std::uint32_t(block[1]) << 16 | std::uint32_t(block[2]) << 8 | block[3];
+        right = std::uint32_t(block[4]) << 24 | std::uint32_t(block[5]) << 16 | std::uint32_t(block[6]) << 8 | block[7];
+
+        /* _desip() */
+        work = ((leftt >> 4) ^ right) & 0x0f0f0f0f;
+        right ^= work;
+        leftt ^= (work << 4);
+        work = ((leftt >> 16) ^ right) & 0x0000ffff;
+        right ^= work;
+        leftt ^= (work << 16);
+        work = ((right >> 2) ^ leftt) & 0x33333333;
+        leftt ^= work;
+        right ^= (work << 2);
+        work = ((right >> 8) ^ leftt) & 0x00ff00ff;
+        leftt ^= work;
+        right ^= (work << 8);
+        right = (right << 1) | (right >> 31);
+        work = (leftt ^ right) & 0xaaaaaaaa;
+        leftt ^= work;
+        right ^= work;
+        leftt = (leftt << 1) | (leftt >> 31);
+
+        for (round = 0; round < Rounds; round += 2)
+        {
+            leftt ^= detail::desf(right, KnL[round << 1], KnL[(round << 1) + 1]);
+            right ^= detail::desf(leftt, KnL[(round << 1) + 2], KnL[(round << 1) + 3]);
+        }
+
+        /* _desfp() */
+        right = (right << 31) | (right >> 1);
+        work = (leftt ^ right) & 0xaaaaaaaa;
+        leftt ^= work;
+        right ^= work;
+        leftt = (leftt << 31) | (leftt >> 1);
+        work = ((leftt >> 8)  ^ right) & 0x00ff00ff;
+        right ^= work;
+        leftt ^= (work << 8);
+        work = ((leftt >> 2)  ^ right) & 0x33333333;
+        right ^= work;
+        leftt ^= (work << 2);
+        work = ((right >> 16) ^ leftt) & 0x0000ffff;
+        leftt ^= work;
+        right ^= (work << 16);
+        work = ((right >> 4)  ^ leftt) & 0x0f0f0f0f;
+        leftt ^= work;
+        right ^= (work << 4);
+
+        /* _unscrun() of (right, leftt) */
+        block[0] = right >> 24; block[1] = right >> 16; block[2] = right >> 8; block[3] = right;
+        block[4] = leftt >> 24; block[5] = leftt >> 16; block[6] = leftt >> 8; block[7] = leftt;
+        std::memcpy(&iprn, block, 8);
+
+        return iprn;
+    }
+
+    /* The PRN for the counter icount as a double in [0, 1), as get_uniform_prn() gives */
+    double uniform(std::uint64_t icount) const noexcept
+    {
+        return (*this)(icount) / (1.0 + double(max()));
+    }
+
+    friend bool operator==(const basic_engine &a, const basic_engine &b) noexcept
+    {
+        return a.nident == b.nident && a.icount == b.icount;
+    }
+    friend bool operator!=(const basic_engine &a, const basic_engine &b) noexcept { return !(a == b); }
+
+private:
+    std::uint64_t nident;
+    std::uint64_t icount;
+    std::uint32_t KnL[32];
+};
+
+using engine = basic_engine<16>;
+using engine12 = basic_engine<12>;
+using engine10 = basic_engine<10>;
+using engine8 = basic_engine<8>;
+
+} // namespace desprng
+
+#endif // DESPRNG_HPP
@@ -0,0 +1,308 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "desprng.h"
+
+/* Writes raw DES PRNG output (8-byte PRNs in native byte order) to stdout or a
+ * file, for external testers such as PractRand (RNG_test stdin64) and
+ * dieharder (-g 200). Output word w comes from stream w % nstream with counter
+ * index j = start + w / nstream, so one stream gives a single sequence, and
+ * two streams whose identifiers differ in the least-significant bit give the
+ * alternating pair of crush2. The counter index is mapped to icount by the
+ * counter layout: with -f nbits,nlow, icount = ((j / nlow) << nbits) + j % nlow,
+ * which for nbits = 16 and nlow = Ncoll is the icount of toypicmcc (itime in
+ * the high six bytes, icoll in the low two).
+ *
+ * The output is made in blocks by nthread threads, with make_prn_range() over
+ * each run of consecutive counters, and written in order by the main thread.
+ * Blocks that are ready are written together with writev(). When the output
+ * is a pipe, the blocks are instead spliced into it with vmsplice() (on
+ * Linux), which saves copying them. The pipe is then resized to one block, so
+ * that once a block has been spliced, the previous one has been read by the
+ * other end and its buffer can be reused.
+ *
+ * Usage: desprnggen [-n nstream] [-p nparticle] [-s start] [-f nbits,nlow]
+ *                   [-b bytes] [-t nthread] [-o file]
+ * nstream defaults to 1 and nparticle (the identifier of the first stream,
+ * stream i has nparticle ^ i) to a random number. Output continues until the
+ * reader closes the pipe, or bytes (rounded up to whole PRNs) have been written.
+ */
+
+/* Bytes per block, also the pipe size for vmsplice() */
+#define Nblock 1048576UL
+/* Maximum number of blocks per writev() */
+#define Niov 16
+/* PRNs per make_prn_range() call */
+#define Nrun 512UL
+
+typedef struct
+{
+    desprng_common_t *process_data;
+    desprng_individual_t *thread_data;
+    unsigned long nstream, start, nbits, nlow, nword;
+    long nthread, nslot;
+    unsigned long *buffer;
+    volatile unsigned long *ready; /* Block number held by each slot, or ~0UL when free */
+    volatile int stop;
+    pthread_mutex_t mutex;
+    pthread_cond_t filled, freed;
+} gen_t;
+
+typedef struct
+{
+    gen_t *gen;
+    long ithread;
+} worker_t;
+
+/* Maps the counter index j to icount */
+static unsigned long layout(gen_t *gen, unsigned long j)
+{
+    return gen->nlow ? ((j / gen->nlow) << gen->nbits) + j % gen->nlow : j;
+}
+
+/* Fills buf with the nword PRNs of block iblock */
+static void fill_block(gen_t *gen, unsigned long iblock, unsigned long *buf)
+{
+    unsigned long iprn[Nrun], w0 = iblock * gen->nword, s, i0, j, n, run, k;
+
+    for (s = 0UL; s < gen->nstream; s++)
+    {
+        /* The first word of stream s in the block, and the number of them */
+        i0 = (s + gen->nstream - w0 % gen->nstream) % gen->nstream;
+        if (i0 >= gen->nword) continue;
+        j = gen->start + (w0 + i0) / gen->nstream;
+        for (n = (gen->nword - i0 + gen->nstream - 1) / gen->nstream; n; n -= run, j += run)
+        {
+            /* A run of consecutive icounts ends where the low field wraps */
+            run = n < Nrun ? n : Nrun;
+            if (gen->nlow && gen->nlow - j % gen->nlow < run) run = gen->nlow - j % gen->nlow;
+            make_prn_range(gen->process_data, gen->thread_data + s, layout(gen, j), run, iprn);
+            for (k = 0UL; k < run; k++, i0 += gen->nstream) buf[i0] = iprn[k];
+        }
+    }
+
+    return;
+}
+
+/* Makes blocks ithread, ithread + nthread, ..., each in slot iblock % nslot once it is free */
+static void *worker(void *arg)
+{
+    gen_t *gen = ((worker_t *)arg)->gen;
+    unsigned long iblock = ((worker_t *)arg)->ithread;
+    long islot;
+
+    for (; ; iblock += gen->nthread)
+    {
+        islot = iblock % gen->nslot;
+        pthread_mutex_lock(&gen->mutex);
+        while (gen->ready[islot] != ~0UL && !gen->stop) pthread_cond_wait(&gen->freed, &gen->mutex);
+        pthread_mutex_unlock(&gen->mutex);
+        if (gen->stop) break;
+
+        fill_block(gen, iblock, gen->buffer + islot * gen->nword);
+
+        pthread_mutex_lock(&gen->mutex);
+        gen->ready[islot] = iblock;
+        pthread_cond_broadcast(&gen->filled);
+        pthread_mutex_unlock(&gen->mutex);
+    }
+
+    return NULL;
+}
+
+/* Writes all of iov[0..niov-1] with writev() (or vmsplice() if splice), and returns 0 or errno */
+static int write_all(int fd, struct iovec *iov, int niov, int splice)
+{
+    ssize_t nbyte;
+
+    while (niov)
+    {
+#ifdef __linux__
+        if (splice)
+            nbyte = vmsplice(fd, iov, niov, 0);
+        else
+#endif
+            nbyte = writev(fd, iov, niov);
+        if (nbyte < 0)
+        {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        for (; niov && (size_t)nbyte >= iov->iov_len; niov--, iov++) nbyte -= iov->iov_len;
+        if (niov)
+        {
+            iov->iov_base = (char *)iov->iov_base + nbyte;
+            iov->iov_len -= nbyte;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    gen_t gen;
+    worker_t *workers;
+    pthread_t *threads;
+    struct iovec iov[Niov];
+    struct stat st;
+    unsigned long nparticle = 0UL, nbyte = 0UL, iblock, lastblock = ~0UL, s, *nident;
+    long ithread, islot, nstarted;
+    int opt, fd = 1, splice = 0, niov, ierr = 0, hasparticle = 0;
+
+    gen.nstream = 1UL;
+    gen.start = gen.nbits = gen.nlow = 0UL;
+    gen.nthread = sysconf(_SC_NPROCESSORS_ONLN);
+    while ((opt = getopt(argc, argv, "n:p:s:f:b:t:o:")) != -1)
+        switch (opt)
+        {
+        case 'n': gen.nstream = strtoul(optarg, NULL, 0); break;
+        case 'p': nparticle = strtoul(optarg, NULL, 0); hasparticle = 1; break;
+        case 's': gen.start = strtoul(optarg, NULL, 0); break;
+        case 'f':
+            if (sscanf(optarg, "%lu,%lu", &gen.nbits, &gen.nlow) != 2 || gen.nbits > 63 || gen.nlow > 1UL << gen.nbits)
+            {
+                fprintf(stderr, "desprnggen: -f needs nbits,nlow with nbits < 64 and nlow <= 2**nbits\n");
+                return 1;
+            }
+            break;
+        case 'b': nbyte = strtoul(optarg, NULL, 0); break;
+        case 't': gen.nthread = atol(optarg); break;
+        case 'o':
+            if ((fd = open(optarg, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+            {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "Usage: desprnggen [-n nstream] [-p nparticle] [-s start] [-f nbits,nlow] [-b bytes] [-t nthread] [-o file]\n");
+            return 1;
+        }
+    if (gen.nstream < 1UL) gen.nstream = 1UL;
+    if (gen.nthread < 1) gen.nthread = 1;
+    if (nbyte) lastblock = (nbyte + Nblock - 1) / Nblock - 1;
+
+    /* Get a proper (not pseudo) 7-byte random number from the /dev/random device */
+    if (!hasparticle && getrandom(&nparticle, 7, GRND_RANDOM) != 7)
+    {
+        perror("desprnggen: getrandom");
+        return 1;
+    }
+    if (ierr = check_type_sizes())
+    {
+        fprintf(stderr, "check_type_sizes() returned the error code %d ()", ierr);
+        return ierr;
+    }
+    /* Stream i gets the identifier nparticle ^ i, so streams 0 and 1 are an odd-even pair */
+    nident = malloc(sizeof(unsigned long) * gen.nstream);
+    gen.thread_data = malloc(sizeof(desprng_individual_t) * gen.nstream);
+    gen.process_data = malloc(sizeof(desprng_common_t));
+    if (!nident || !gen.thread_data || !gen.process_data)
+    {
+        fprintf(stderr, "desprnggen: out of memory for %lu streams\n", gen.nstream);
+        return 1;
+    }
+    for (s = 0UL; s < gen.nstream; s++) nident[s] = (nparticle ^ s) & 0x00ffffffffffffffUL;
+    initialize_common(gen.process_data);
+    if (initialize_individuals(gen.process_data, gen.thread_data, nident, gen.nstream))
+    {
+        fprintf(stderr, "desprnggen: too many streams for the particle number %014lX\n", nparticle);
+        return 1;
+    }
+    free(nident);
+
+#ifdef __linux__
+    /* Splice into a pipe that holds exactly one block (see above) */
+    if (!fstat(fd, &st) && S_ISFIFO(st.st_mode) && fcntl(fd, F_SETPIPE_SZ, (int)Nblock) == (int)Nblock) splice = 1;
+#else
+    (void)st;
+#endif
+    /* With vmsplice() a slot is freed one block late, so make sure there is one more than the threads fill */
+    gen.nslot = 2 * gen.nthread + 1;
+    gen.nword = Nblock / sizeof(unsigned long);
+    gen.stop = 0;
+    gen.ready = malloc(sizeof(unsigned long) * gen.nslot);
+    workers = malloc(sizeof(worker_t) * gen.nthread);
+    threads = malloc(sizeof(pthread_t) * gen.nthread);
+    if (posix_memalign((void **)&gen.buffer, 4096, gen.nslot * Nblock) || !gen.ready || !workers || !threads)
+    {
+        fprintf(stderr, "desprnggen: out of memory for %ld threads\n", gen.nthread);
+        return 1;
+    }
+    for (islot = 0; islot < gen.nslot; islot++) gen.ready[islot] = ~0UL;
+    pthread_mutex_init(&gen.mutex, NULL);
+    pthread_cond_init(&gen.filled, NULL);
+    pthread_cond_init(&gen.freed, NULL);
+    /* A closed pipe ends the output with EPIPE */
+    signal(SIGPIPE, SIG_IGN);
+
+    for (nstarted = 0; nstarted < gen.nthread; nstarted++)
+    {
+        workers[nstarted].gen = &gen;
+        workers[nstarted].ithread = nstarted;
+        if (ierr = pthread_create(threads + nstarted, NULL, worker, workers + nstarted))
+        {
+            /* Each thread makes its own blocks, so all of them are needed */
+            fprintf(stderr, "desprnggen: could not start thread %ld: %s\n", nstarted, strerror(ierr));
+            ierr = 1;
+            break;
+        }
+    }
+
+    /* Write the blocks in order, as many at a time as are ready */
+    for (iblock = 0UL; iblock <= lastblock && !ierr; iblock += niov)
+    {
+        pthread_mutex_lock(&gen.mutex);
+        while (gen.ready[iblock % gen.nslot] != iblock) pthread_cond_wait(&gen.filled, &gen.mutex);
+        for (niov = 0; niov < Niov && iblock + niov <= lastblock && gen.ready[(iblock + niov) % gen.nslot] == iblock + niov; niov++)
+        {
+            iov[niov].iov_base = gen.buffer + (iblock + niov) % gen.nslot * gen.nword;
+            iov[niov].iov_len = iblock + niov == lastblock && nbyte % Nblock ? (nbyte % Nblock + 7) / 8 * 8 : Nblock;
+        }
+        pthread_mutex_unlock(&gen.mutex);
+
+        if (ierr = write_all(fd, iov, niov, splice))
+        {
+            if (ierr == EPIPE)
+                ierr = 0;
+            else
+                fprintf(stderr, "desprnggen: %s\n", strerror(ierr));
+            break;
+        }
+
+        pthread_mutex_lock(&gen.mutex);
+        for (islot = 0; islot < niov; islot++)
+            /* The pages of a spliced block may still be in the pipe until the next one has been spliced */
+            if (!splice || islot < niov - 1) gen.ready[(iblock + islot) % gen.nslot] = ~0UL;
+        if (splice && iblock) gen.ready[(iblock - 1) % gen.nslot] = ~0UL;
+        pthread_cond_broadcast(&gen.freed);
+        pthread_mutex_unlock(&gen.mutex);
+    }
+
+    pthread_mutex_lock(&gen.mutex);
+    gen.stop = 1;
+    pthread_cond_broadcast(&gen.freed);
+    pthread_mutex_unlock(&gen.mutex);
+    for (ithread = 0; ithread < nstarted; ithread++) pthread_join(threads[ithread], NULL);
+    if (fd != 1) close(fd);
+
+    free(threads);
+    free(workers);
+    free((void *)gen.ready);
+    free(gen.buffer);
+    free(gen.process_data);
+    free(gen.thread_data);
+
+    return ierr;
+}
@@ -0,0 +1,96 @@
+/* Copyright (c) 2020, Johan Carlsson and RadiaSoft LLC
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Lock-free reservation of counter ranges, for schedulers that do not know in
+ * advance how many PRNs a particle will need in a time step (and so cannot use
+ * a fixed counter layout like the itime << 16 + icoll of toypicmcc). A
+ * desprng_counter_t holds the next free counter of an identifier (or of a
+ * block of identifiers that share it, since the PRNs of different identifiers
+ * are independent for the same counters anyway), and any thread can reserve
+ * the next n counters from it. The reservation is a compare-and-swap loop, so
+ * a range is never handed out twice, and the counter never wraps around: a
+ * reservation that would go past the end of the counter space fails instead.
+ */
+
+#include "desprng.h"
+
+/* Without the GCC atomic builtins, the C11 atomics are used on the counter
+   (which has the size and alignment of an _Atomic unsigned long). There is no
+   fallback on a lock, or on a plain (racy) update */
+#ifndef __GNUC__
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define _NEXT(counter) ((_Atomic unsigned long *)&(counter)->next)
+#else
+#error "desreserve.c needs the GCC atomic builtins or the C11 atomics"
+#endif
+#endif
+
+
+/* Sets the next free counter of counter to icount_start */
+int desprng_counter_init(desprng_counter_t *counter, unsigned long icount_start)
+{
+#ifdef __GNUC__
+    __atomic_store_n(&counter->next, icount_start, __ATOMIC_RELAXED);
+#else
+    atomic_store_explicit(_NEXT(counter), icount_start, memory_order_relaxed);
+#endif
+
+    return 0;
+}
+
+
+/* Reserves the n counters *icount_start, *icount_start + 1, ...,
+   *icount_start + n - 1 for the caller, and no one else. Returns 0, or -1
+   (and reserves nothing) if that would go past the last counter, 2**64 - 1
+   (which is never handed out, so that a full counter can be told apart) */
+int desprng_reserve(desprng_counter_t *counter, unsigned long n, unsigned long *icount_start)
+{
+    unsigned long next;
+
+#ifdef __GNUC__
+    next = __atomic_load_n(&counter->next, __ATOMIC_RELAXED);
+    do
+        if (n > ~0UL - next) return -1;
+    while (!__atomic_compare_exchange_n(&counter->next, &next, next + n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#else
+    next = atomic_load_explicit(_NEXT(counter), memory_order_relaxed);
+    do
+        if (n > ~0UL - next) return -1;
+    while (!atomic_compare_exchange_weak_explicit(_NEXT(counter), &next, next + n, memory_order_relaxed, memory_order_relaxed));
+#endif
+    *icount_start = next;
+
+    return 0;
+}
+
+
+/* Returns the number of counters left to reserve */
+unsigned long desprng_counter_left(desprng_counter_t *counter)
+{
+#ifdef __GNUC__
+    return ~0UL - __atomic_load_n(&counter->next, __ATOMIC_RELAXED);
+#else
+    return ~0UL - atomic_load_explicit(_NEXT(counter), memory_order_relaxed);
+#endif
+}
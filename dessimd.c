@@ -0,0 +1,224 @@
+/* Copyright (c) 2020, Johan Carlsson and RadiaSoft LLC
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are met:
+
+   1. Redistributions of source code must retain the above copyright notice, this
+      list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+   ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+   WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+   ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+   (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+   LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+   ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* SIMD DES PRNG backend for CPU, which runs _desfunc() for 8 (AVX2) or
+ * 16 (AVX-512) particles at once, one per 32-bit vector lane. The SP lookups
+ * are vector gathers from desprng_common_t, and the subkeys of each lane are
+ * gathered from its own desprng_individual_t. The instruction set is picked
+ * at run time, so libdesprng.a does not need to be compiled with -mavx2.
+ * Without AVX2 (or on other architectures and compilers) make_prn() is used.
+ */
+
+#include <string.h>
+#include "desprng.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__NVCOMPILER)
+#define DESPRNG_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef DESPRNG_SIMD
+
+typedef unsigned int v8u_t __attribute__ ((vector_size (32)));
+typedef unsigned int v16u_t __attribute__ ((vector_size (64)));
+
+/* The SP and KnL arrays hold unsigned longs, so a gather with a scale of 8
+   that loads 32 bits picks up the (little-endian) low half of each entry */
+#define SP8(k, work) ((v8u_t)_mm256_i32gather_epi32((const int *)process_data->SP[k], (__m256i)((work) & 0x3f), 8))
+#define SP16(k, work) ((v16u_t)_mm512_i32gather_epi32((__m512i)((work) & 0x3f), (const void *)process_data->SP[k], 8))
+
+/* The vector versions of _desip(), _desfp() and the round loop in _desfunc().
+   With 32-bit lanes, the masking after the rotations is not needed */
+#define SIMD_DESIP(leftt, right, work) \
+    work = ((leftt >> 4) ^ right) & 0x0f0f0f0f; \
+    right ^= work; \
+    leftt ^= (work << 4); \
+    work = ((leftt >> 16) ^ right) & 0x0000ffff; \
+    right ^= work; \
+    leftt ^= (work << 16); \
+    work = ((right >> 2) ^ leftt) & 0x33333333; \
+    leftt ^= work; \
+    right ^= (work << 2); \
+    work = ((right >> 8) ^ leftt) & 0x00ff00ff; \
+    leftt ^= work; \
+    right ^= (work << 8); \
+    right = (right << 1) | (right >> 31); \
+    work = (leftt ^ right) & 0xaaaaaaaa; \
+    leftt ^= work; \
+    right ^= work; \
+    leftt = (leftt << 1) | (leftt >> 31)
+
+#define SIMD_DESFP(leftt, right, work) \
+    right = (right << 31) | (right >> 1); \
+    work = (leftt ^ right) & 0xaaaaaaaa; \
+    leftt ^= work; \
+    right ^= work; \
+    leftt = (leftt << 31) | (leftt >> 1); \
+    work = ((leftt >> 8)  ^ right) & 0x00ff00ff; \
+    right ^= work; \
+    leftt ^= (work << 8); \
+    work = ((leftt >> 2)  ^ right) & 0x33333333; \
+    right ^= work; \
+    leftt ^= (work << 2); \
+    work = ((right >> 16) ^ leftt) & 0x0000ffff; \
+    leftt ^= work; \
+    right ^= (work << 16); \
+    work = ((right >> 4)  ^ leftt) & 0x0f0f0f0f; \
+    leftt ^= work; \
+    right ^= (work << 4)
+
+#define SIMD_DESHALF(SP, leftt, right, work, fval, key0, key1) \
+    work  = (right << 28) | (right >> 4); \
+    work ^= key0; \
+    fval  = SP(6, work); \
+    fval |= SP(4, work >>  8); \
+    fval |= SP(2, work >> 16); \
+    fval |= SP(0, work >> 24); \
+    work  = right ^ key1; \
+    fval |= SP(7, work); \
+    fval |= SP(5, work >>  8); \
+    fval |= SP(3, work >> 16); \
+    fval |= SP(1, work >> 24); \
+    leftt ^= fval
+
+
+/* Eight PRNs with AVX2 */
+__attribute__ ((target ("avx2")))
+static void _desavx2(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long *icount, unsigned long *iprn)
+{
+    v8u_t leftt, right, work, fval, stride, keys[32];
+    unsigned int half[2][8];
+    int j, round;
+
+    /* _scrunch() on a little-endian CPU */
+    for (j = 0; j < 8; j++)
+    {
+        half[0][j] = __builtin_bswap32((unsigned int)icount[j]);
+        half[1][j] = __builtin_bswap32((unsigned int)(icount[j] >> 32));
+    }
+    memcpy(&leftt, half[0], 32);
+    memcpy(&right, half[1], 32);
+
+    /* Lane j reads its subkeys from thread_data[j] */
+    for (j = 0; j < 8; j++) stride[j] = j * (sizeof(desprng_individual_t) / sizeof(unsigned long));
+    for (j = 0; j < 32; j++)
+        keys[j] = (v8u_t)_mm256_i32gather_epi32((const int *)(thread_data->KnL + j), (__m256i)stride, 8);
+
+    SIMD_DESIP(leftt, right, work);
+    for (round = 0; round < 8; round++)
+    {
+        SIMD_DESHALF(SP8, leftt, right, work, fval, keys[round << 2], keys[(round << 2) + 1]);
+        SIMD_DESHALF(SP8, right, leftt, work, fval, keys[(round << 2) + 2], keys[(round << 2) + 3]);
+    }
+    SIMD_DESFP(leftt, right, work);
+
+    /* _unscrun() of (right, leftt) on a little-endian CPU */
+    memcpy(half[0], &right, 32);
+    memcpy(half[1], &leftt, 32);
+    for (j = 0; j < 8; j++)
+        iprn[j] = (unsigned long)__builtin_bswap32(half[0][j]) | (unsigned long)__builtin_bswap32(half[1][j]) << 32;
+
+    return;
+}
+
+
+/* Sixteen PRNs with AVX-512 */
+__attribute__ ((target ("avx512f")))
+static void _desavx512(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long *icount, unsigned long *iprn)
+{
+    v16u_t leftt, right, work, fval, stride, keys[32];
+    unsigned int half[2][16];
+    int j, round;
+
+    for (j = 0; j < 16; j++)
+    {
+        half[0][j] = __builtin_bswap32((unsigned int)icount[j]);
+        half[1][j] = __builtin_bswap32((unsigned int)(icount[j] >> 32));
+    }
+    memcpy(&leftt, half[0], 64);
+    memcpy(&right, half[1], 64);
+
+    for (j = 0; j < 16; j++) stride[j] = j * (sizeof(desprng_individual_t) / sizeof(unsigned long));
+    for (j = 0; j < 32; j++)
+        keys[j] = (v16u_t)_mm512_i32gather_epi32((__m512i)stride, (const void *)(thread_data->KnL + j), 8);
+
+    SIMD_DESIP(leftt, right, work);
+    for (round = 0; round < 8; round++)
+    {
+        SIMD_DESHALF(SP16, leftt, right, work, fval, keys[round << 2], keys[(round << 2) + 1]);
+        SIMD_DESHALF(SP16, right, leftt, work, fval, keys[(round << 2) + 2], keys[(round << 2) + 3]);
+    }
+    SIMD_DESFP(leftt, right, work);
+
+    memcpy(half[0], &right, 64);
+    memcpy(half[1], &leftt, 64);
+    for (j = 0; j < 16; j++)
+        iprn[j] = (unsigned long)__builtin_bswap32(half[0][j]) | (unsigned long)__builtin_bswap32(half[1][j]) << 32;
+
+    return;
+}
+
+#endif /* DESPRNG_SIMD */
+
+
+/* Returns the number of particles that make_prn_simd() processes per vector
+   on this CPU, or 1 if it falls back on make_prn(). The CPU is probed on the
+   first call only (by every thread that gets there first, with the same
+   result), so that the bulk path does not pay for it */
+int get_simd_lanes()
+{
+#ifdef DESPRNG_SIMD
+    static int lanes = 0;
+    int l = __atomic_load_n(&lanes, __ATOMIC_RELAXED);
+
+    if (!l)
+    {
+        __builtin_cpu_init();
+        l = __builtin_cpu_supports("avx512f") ? 16 : __builtin_cpu_supports("avx2") ? 8 : 1;
+        __atomic_store_n(&lanes, l, __ATOMIC_RELAXED);
+    }
+    return l;
+#else
+    return 1;
+#endif
+}
+
+
+/* Computes n unsigned long PRNs, one for each thread_data[i] and icount[i],
+   with the same output as make_prn() */
+int make_prn_simd(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long n, unsigned long *icount, unsigned long *iprn)
+{
+    unsigned long i = 0UL;
+    int lanes = get_simd_lanes();
+
+#ifdef DESPRNG_SIMD
+    if (lanes == 16)
+        for (; i + 16 <= n; i += 16) _desavx512(process_data, thread_data + i, icount + i, iprn + i);
+    else if (lanes == 8)
+        for (; i + 8 <= n; i += 8) _desavx2(process_data, thread_data + i, icount + i, iprn + i);
+#endif
+    /* The remainder (or everything, without SIMD) */
+    for (; i < n; i++) make_prn(process_data, thread_data + i, icount[i], iprn + i);
+
+    return 0;
+}
@@ -0,0 +1,506 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <sys/random.h>
+
+#include "desprng.h"
+
+/* A self-contained statistical test battery for the DES PRNG, which does not
+   need TestU01. Every test is run on each of Nstream streams (adjacent
+   particle numbers, so the identifiers differ in their low bits), and the
+   tests and streams run in parallel when compiled with OpenMP. The PRNs come
+   from make_prn_range() over the counters 0, 1, 2, ...
+
+   Like the TestU01 batteries, each test gives a p-value, which is flagged as
+   suspect outside [0.001, 0.999]. As there, the p-values of the chi-square
+   tests and the birthday spacings test are right tails, so a p-value near 1
+   means too good a fit, or too few collisions. A p-value outside [1e-6, 1 - 1e-6] is a
+   failure, and then the exit status is 1, so that the battery can be used as
+   a quality gate (e.g. after changing compilers or flags).
+
+   Usage: desstat [scale [nparticle]]
+   The sample sizes are multiplied by scale (default 1), and the streams use
+   the particle numbers nparticle, nparticle + 1, ... (default random). */
+
+/* With -DDESPRNG_NP1, the PRNG-only variant is tested instead, and with
+   -DDESPRNG_ROUNDS=8, 10 or 12, the reduced-round tier */
+#ifdef DESPRNG_NP1
+#define make_prn make_prn_np1
+#define make_prn_range make_prn_range_np1
+#elif defined(DESPRNG_ROUNDS) && DESPRNG_ROUNDS != 16
+#if DESPRNG_ROUNDS == 8
+#define make_prn make_prn8
+#elif DESPRNG_ROUNDS == 10
+#define make_prn make_prn10
+#elif DESPRNG_ROUNDS == 12
+#define make_prn make_prn12
+#else
+#error "DESPRNG_ROUNDS must be 8, 10, 12 or 16"
+#endif
+#define make_prn_range make_prn_range_rounds
+/* The tiers have no range function, so make the PRNs one at a time */
+static int make_prn_range_rounds(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned long icount_start, unsigned long n, unsigned long *iprn)
+{
+    unsigned long i;
+
+    for (i = 0UL; i < n; i++) make_prn(process_data, thread_data, icount_start + i, iprn + i);
+
+    return 0;
+}
+#endif
+
+#define Nstream 4
+#define Nbuffer 4096UL
+
+/* The result of one test on one stream */
+typedef struct desstat_result
+{
+    const char *name;
+    long stream;
+    double statistic;
+    double pvalue;
+}
+result_t;
+
+/* The stream of PRNs that a test reads, Nbuffer at a time */
+typedef struct desstat_stream
+{
+    desprng_common_t *process_data;
+    desprng_individual_t thread_data;
+    unsigned long icount, ibuffer, buffer[Nbuffer];
+}
+stream_t;
+
+static unsigned long next(stream_t *s)
+{
+    if (s->ibuffer == Nbuffer)
+    {
+        make_prn_range(s->process_data, &s->thread_data, s->icount, Nbuffer, s->buffer);
+        s->icount += Nbuffer;
+        s->ibuffer = 0UL;
+    }
+    return s->buffer[s->ibuffer++];
+}
+
+
+static double igam(double a, double x);
+static double igamc(double a, double x);
+
+/* Regularized lower incomplete gamma function P(a, x), by its series */
+static double igam(double a, double x)
+{
+    double ax, r, c, sum;
+
+    if (x <= 0.0) return 0.0;
+    if (x > 1.0 && x > a) return 1.0 - igamc(a, x);
+    ax = a * log(x) - x - lgamma(a);
+    if (ax < -700.0) return 0.0;
+    r = a;
+    c = sum = 1.0;
+    do
+    {
+        r += 1.0;
+        c *= x / r;
+        sum += c;
+    }
+    while (c > sum * DBL_EPSILON);
+
+    return sum * exp(ax) / a;
+}
+
+/* Regularized upper incomplete gamma function Q(a, x) = 1 - P(a, x), by its
+   continued fraction (as in Cephes) */
+static double igamc(double a, double x)
+{
+    double ax, y, z, c, yc, r, t, pk, pkm1, pkm2, qk, qkm1, qkm2, ans;
+
+    if (x <= 0.0) return 1.0;
+    if (x < 1.0 || x < a) return 1.0 - igam(a, x);
+    ax = a * log(x) - x - lgamma(a);
+    if (ax < -700.0) return 0.0;
+    y = 1.0 - a;
+    z = x + y + 1.0;
+    c = 0.0;
+    pkm2 = 1.0;
+    qkm2 = x;
+    pkm1 = x + 1.0;
+    qkm1 = z * x;
+    ans = pkm1 / qkm1;
+    do
+    {
+        c += 1.0;
+        y += 1.0;
+        z += 2.0;
+        yc = y * c;
+        pk = pkm1 * z - pkm2 * yc;
+        qk = qkm1 * z - qkm2 * yc;
+        if (qk != 0.0)
+        {
+            r = pk / qk;
+            t = fabs((ans - r) / r);
+            ans = r;
+        }
+        else
+            t = 1.0;
+        pkm2 = pkm1;
+        pkm1 = pk;
+        qkm2 = qkm1;
+        qkm1 = qk;
+        if (fabs(pk) > 1.0 / DBL_EPSILON)
+        {
+            pkm2 *= DBL_EPSILON;
+            pkm1 *= DBL_EPSILON;
+            qkm2 *= DBL_EPSILON;
+            qkm1 *= DBL_EPSILON;
+        }
+    }
+    while (t > DBL_EPSILON);
+
+    return ans * exp(ax);
+}
+
+/* The p-value (right tail) of a chi-square statistic with df degrees of freedom */
+static double chisquare(double chi2, double df)
+{
+    return igamc(0.5 * df, 0.5 * chi2);
+}
+
+/* The two-sided p-value of a standard normal statistic */
+static double normal(double z)
+{
+    return erfc(fabs(z) / M_SQRT2);
+}
+
+
+/* Frequency (monobit) test: the number of one bits in n words */
+static void frequency(stream_t *s, unsigned long n, result_t *r)
+{
+    unsigned long i, ones = 0UL;
+
+    for (i = 0UL; i < n; i++) ones += __builtin_popcountl(next(s));
+    r->statistic = (2.0 * ones - 64.0 * n) / sqrt(64.0 * n);
+    r->pvalue = normal(r->statistic);
+}
+
+/* Serial test: chi-square of the 65536 pairs of consecutive bytes, four
+   (non-overlapping) pairs per word */
+static void serial(stream_t *s, unsigned long n, result_t *r)
+{
+    unsigned long i, j, iprn, *count = calloc(65536, sizeof(unsigned long));
+    double expected = 4.0 * n / 65536.0, chi2 = 0.0;
+
+    if (!count)
+    {
+        fprintf(stderr, "desstat: out of memory in %s\n", r->name);
+        exit(1);
+    }
+    for (i = 0UL; i < n; i++)
+        for (iprn = next(s), j = 0; j < 4; j++, iprn >>= 16) count[iprn & 0xffff]++;
+    for (j = 0UL; j < 65536; j++) chi2 += (count[j] - expected) * (count[j] - expected) / expected;
+    free(count);
+    r->statistic = chi2;
+    r->pvalue = chisquare(chi2, 65535.0);
+}
+
+/* Gap test: the lengths of the gaps between the words that, as fractions of
+   2**64, fall in [0, 1/16), in classes 0, ..., Ngap - 1 and >= Ngap */
+#define Ngap 96
+static void gap(stream_t *s, unsigned long n, result_t *r)
+{
+    unsigned long i, length = 0UL, ngap = 0UL, count[Ngap + 1] = {0UL};
+    double p = 1.0 / 16.0, expected, chi2 = 0.0;
+    int j;
+
+    for (i = 0UL; i < n; i++)
+        if (next(s) >> 60)
+            length++;
+        else
+        {
+            count[length < Ngap ? length : Ngap]++;
+            ngap++;
+            length = 0UL;
+        }
+    for (j = 0; j <= Ngap; j++)
+    {
+        expected = ngap * (j < Ngap ? p * pow(1.0 - p, j) : pow(1.0 - p, Ngap));
+        chi2 += (count[j] - expected) * (count[j] - expected) / expected;
+    }
+    r->statistic = chi2;
+    r->pvalue = chisquare(chi2, Ngap);
+}
+
+/* Birthday spacings test: Nbirthday birthdays (the top 36 bits of each word)
+   in a year of 2**36 days. The number of repeated spacings between the sorted
+   birthdays is Poisson with mean Nbirthday**3 / (4 * 2**36) = 2 per sample,
+   and the statistic is the total over n samples */
+#define Nbirthday 8192UL
+static int compare(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+
+    return x < y ? -1 : x > y;
+}
+static void birthday(stream_t *s, unsigned long n, result_t *r)
+{
+    unsigned long i, j, collisions = 0UL, *day = malloc(Nbirthday * sizeof(unsigned long));
+    double lambda = 2.0 * n;
+
+    if (!day)
+    {
+        fprintf(stderr, "desstat: out of memory in %s\n", r->name);
+        exit(1);
+    }
+    for (i = 0UL; i < n; i++)
+    {
+        for (j = 0UL; j < Nbirthday; j++) day[j] = next(s) >> 28;
+        qsort(day, Nbirthday, sizeof(unsigned long), compare);
+        for (j = Nbirthday - 1; j > 0; j--) day[j] -= day[j - 1];
+        qsort(day, Nbirthday, sizeof(unsigned long), compare);
+        for (j = 1UL; j < Nbirthday; j++) collisions += day[j] == day[j - 1];
+    }
+    free(day);
+    r->statistic = collisions;
+    /* P(X >= collisions) for X Poisson with mean lambda, which is near 1 (and
+       flagged) if there are too few collisions, not only if there are too many */
+    r->pvalue = collisions ? igam(collisions, lambda) : 1.0;
+}
+
+/* Linear complexity test (as in NIST SP 800-22): Berlekamp-Massey on n blocks
+   of Mblock bits of the concatenated words, with the deviations of the linear
+   complexity from its mean in seven classes */
+#define Mblock 512
+static void complexity(stream_t *s, unsigned long n, result_t *r)
+{
+    const double pi[7] = {0.010417, 0.03125, 0.125, 0.5, 0.25, 0.0625, 0.020833};
+    unsigned char bits[Mblock], b[Mblock], c[Mblock], t[Mblock];
+    unsigned long i, count[7] = {0UL}, iprn = 0UL;
+    double mu, tstat, chi2 = 0.0;
+    int j, k, l, m, d;
+
+    mu = Mblock / 2.0 + (9.0 - 1.0) / 36.0 - (Mblock / 3.0 + 2.0 / 9.0) / pow(2.0, Mblock);
+    for (i = 0UL; i < n; i++)
+    {
+        for (j = 0; j < Mblock; j++)
+        {
+            if (!(j & 63)) iprn = next(s);
+            bits[j] = (iprn >> (j & 63)) & 1;
+        }
+        /* Berlekamp-Massey */
+        memset(b, 0, Mblock);
+        memset(c, 0, Mblock);
+        b[0] = c[0] = 1;
+        l = 0;
+        m = -1;
+        for (j = 0; j < Mblock; j++)
+        {
+            d = bits[j];
+            for (k = 1; k <= l; k++) d ^= c[k] & bits[j - k];
+            if (d)
+            {
+                memcpy(t, c, Mblock);
+                for (k = 0; k + j - m < Mblock; k++) c[k + j - m] ^= b[k];
+                if (2 * l <= j)
+                {
+                    l = j + 1 - l;
+                    m = j;
+                    memcpy(b, t, Mblock);
+                }
+            }
+        }
+        tstat = l - mu + 2.0 / 9.0; /* (-1)**Mblock = 1 */
+        count[tstat <= -2.5 ? 0 : tstat <= -1.5 ? 1 : tstat <= -0.5 ? 2 : tstat <= 0.5 ? 3 : tstat <= 1.5 ? 4 : tstat <= 2.5 ? 5 : 6]++;
+    }
+    for (j = 0; j < 7; j++) chi2 += (count[j] - n * pi[j]) * (count[j] - n * pi[j]) / (n * pi[j]);
+    r->statistic = chi2;
+    r->pvalue = chisquare(chi2, 6.0);
+}
+
+/* Binary matrix rank test: the ranks over GF(2) of n 64x64 matrices, one word
+   per row, in the classes 64, 63 and <= 62 */
+static void rank(stream_t *s, unsigned long n, result_t *r)
+{
+    const double p[3] = {0.2887880951, 0.5775761902, 0.1336357147};
+    unsigned long i, row[64], pivot, count[3] = {0UL};
+    double chi2 = 0.0;
+    int j, k, col, rnk;
+
+    for (i = 0UL; i < n; i++)
+    {
+        for (j = 0; j < 64; j++) row[j] = next(s);
+        for (rnk = 0, col = 0; col < 64 && rnk < 64; col++)
+        {
+            for (k = rnk; k < 64 && !((row[k] >> col) & 1UL); k++);
+            if (k == 64) continue;
+            pivot = row[k];
+            row[k] = row[rnk];
+            row[rnk] = pivot;
+            for (k = rnk + 1; k < 64; k++)
+                if ((row[k] >> col) & 1UL) row[k] ^= pivot;
+            rnk++;
+        }
+        count[rnk == 64 ? 0 : rnk == 63 ? 1 : 2]++;
+    }
+    for (j = 0; j < 3; j++) chi2 += (count[j] - n * p[j]) * (count[j] - n * p[j]) / (n * p[j]);
+    r->statistic = chi2;
+    r->pvalue = chisquare(chi2, 2.0);
+}
+
+/* Avalanche test over adjacent identifiers: for n counters, how often each of
+   the 64 output bits flips when one of the 56 bits of the particle number is
+   flipped. Each of the 56 * 64 flip counts should be binomial with p = 1/2 */
+static void avalanche_ident(desprng_common_t *process_data, unsigned long nparticle, unsigned long n, result_t *r)
+{
+    desprng_individual_t *thread_data = malloc(57 * sizeof(desprng_individual_t));
+    unsigned long i, iprn, jprn, diff, (*count)[64] = calloc(56, sizeof(*count)), nparticles[57];
+    double chi2 = 0.0;
+    int j, k;
+
+    nparticles[0] = nparticle;
+    for (j = 0; j < 56; j++) nparticles[j + 1] = nparticle ^ (1UL << j);
+    if (!thread_data || !count || initialize_individuals(process_data, thread_data, nparticles, 57))
+    {
+        fprintf(stderr, "desstat: could not set up the streams of %s\n", r->name);
+        exit(1);
+    }
+    for (i = 0UL; i < n; i++)
+    {
+        make_prn(process_data, thread_data, i, &iprn);
+        for (j = 0; j < 56; j++)
+        {
+            make_prn(process_data, thread_data + j + 1, i, &jprn);
+            for (diff = iprn ^ jprn, k = 0; k < 64; k++) count[j][k] += (diff >> k) & 1UL;
+        }
+    }
+    for (j = 0; j < 56; j++)
+        for (k = 0; k < 64; k++) chi2 += (count[j][k] - 0.5 * n) * (count[j][k] - 0.5 * n) / (0.25 * n);
+    free(count);
+    free(thread_data);
+    r->statistic = chi2;
+    r->pvalue = chisquare(chi2, 56.0 * 64.0);
+}
+
+/* Same as avalanche_ident(), but flipping each of the 64 bits of the counter */
+static void avalanche_count(stream_t *s, unsigned long n, result_t *r)
+{
+    unsigned long i, icount, iprn, jprn, diff, (*count)[64] = calloc(64, sizeof(*count));
+    double chi2 = 0.0;
+    int j, k;
+
+    if (!count)
+    {
+        fprintf(stderr, "desstat: out of memory in %s\n", r->name);
+        exit(1);
+    }
+    for (i = 0UL; i < n; i++)
+    {
+        icount = next(s);
+        make_prn(s->process_data, &s->thread_data, icount, &iprn);
+        for (j = 0; j < 64; j++)
+        {
+            make_prn(s->process_data, &s->thread_data, icount ^ (1UL << j), &jprn);
+            for (diff = iprn ^ jprn, k = 0; k < 64; k++) count[j][k] += (diff >> k) & 1UL;
+        }
+    }
+    for (j = 0; j < 64; j++)
+        for (k = 0; k < 64; k++) chi2 += (count[j][k] - 0.5 * n) * (count[j][k] - 0.5 * n) / (0.25 * n);
+    free(count);
+    r->statistic = chi2;
+    r->pvalue = chisquare(chi2, 64.0 * 64.0);
+}
+
+
+#define Ntest 8
+
+int main(int argc, char *argv[])
+{
+    const char *names[Ntest] = {"Frequency", "Serial", "Gap", "BirthdaySpacings", "LinearComplexity", "MatrixRank",
+                                "AvalancheIdentifier", "AvalancheCounter"};
+    desprng_common_t process_data;
+    result_t results[Ntest * Nstream];
+    unsigned long nparticle;
+    double scale = 1.0;
+    int itask, nsuspect = 0, nfail = 0;
+
+    if (argc > 1) scale = atof(argv[1]);
+    if (argc > 2)
+        nparticle = strtoul(argv[2], NULL, 0);
+    else
+    {
+        /* Get a proper (not pseudo) 7-byte random number from the /dev/random device */
+        nparticle = 0UL;
+        if (getrandom(&nparticle, 7, GRND_RANDOM) != 7)
+        {
+            perror("desstat: getrandom");
+            return 1;
+        }
+    }
+    nparticle &= 0x00ffffffffffffffUL;
+    if (nparticle > 0x00ffffffffffffffUL - Nstream) nparticle -= Nstream;
+    initialize_common(&process_data);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (itask = 0; itask < Ntest * Nstream; itask++)
+    {
+        int itest = itask / Nstream;
+        unsigned long nident;
+        stream_t *s = malloc(sizeof(stream_t));
+        result_t *r = results + itask;
+
+        r->name = names[itest];
+        r->stream = itask % Nstream;
+        nident = nparticle + r->stream;
+        if (!s || create_identifier(&nident))
+        {
+            fprintf(stderr, "desstat: could not set up stream %ld of %s\n", r->stream, r->name);
+            exit(1);
+        }
+        s->process_data = &process_data;
+        initialize_individual(&process_data, &s->thread_data, nident);
+        s->icount = 0UL;
+        s->ibuffer = Nbuffer;
+
+        switch (itest)
+        {
+        case 0: frequency(s, scale * 16777216, r); break;
+        case 1: serial(s, scale * 16777216, r); break;
+        case 2: gap(s, scale * 16777216, r); break;
+        case 3: birthday(s, scale * 2000, r); break;
+        case 4: complexity(s, scale * 4000, r); break;
+        case 5: rank(s, scale * 100000, r); break;
+        case 6: avalanche_ident(&process_data, nparticle + r->stream, scale * 20000, r); break;
+        case 7: avalanche_count(s, scale * 20000, r); break;
+        }
+        free(s);
+    }
+
+    printf("========= Summary results of desstat =========\n\n");
+    printf("Particle numbers: 0x%014lX to 0x%014lX\n\n", nparticle, nparticle + Nstream - 1);
+    printf("       Test              Stream      Statistic          p-value\n");
+    printf("------------------------------------------------------------------\n");
+    for (itask = 0; itask < Ntest * Nstream; itask++)
+    {
+        result_t *r = results + itask;
+        const char *flag = "";
+
+        if (r->pvalue < 1.0e-6 || r->pvalue > 1.0 - 1.0e-6)
+        {
+            flag = "  FAIL";
+            nfail++;
+        }
+        else if (r->pvalue < 0.001 || r->pvalue > 0.999)
+        {
+            flag = "  suspect";
+            nsuspect++;
+        }
+        printf("%-24s %4ld  %14.4f  %14.4e%s\n", r->name, r->stream, r->statistic, r->pvalue, flag);
+    }
+    printf("------------------------------------------------------------------\n");
+    if (!nfail && !nsuspect)
+        printf("All tests were passed\n");
+    else
+        printf("%d suspect and %d failed p-values out of %d\n", nsuspect, nfail, Ntest * Nstream);
+
+    return nfail > 0;
+}
@@ -0,0 +1,78 @@
+/* Checks that desprng::engine in desprng.hpp gives the same PRNs as make_prn()
+   in libdesprng.a, and that it works with <random> and <algorithm> */
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "desprng.hpp"
+#include "desprng.h"
+
+int main()
+{
+    desprng_common_t process_data;
+    desprng_individual_t thread_data;
+    unsigned long nident, icount, iprn;
+    std::uint64_t npart;
+
+    initialize_common(&process_data);
+
+    /* Spread the particle numbers and counters over their ranges */
+    for (npart = 0; npart < 1000; npart++)
+    {
+        nident = npart * 0x0123456789abcdUL & 0x00ffffffffffffffUL;
+        assert(!create_identifier(&nident));
+        std::uint64_t nident2 = npart * 0x0123456789abcdUL & 0x00ffffffffffffffUL;
+        assert(desprng::engine::create_identifier(nident2) && nident2 == nident);
+
+        initialize_individual(&process_data, &thread_data, nident);
+        desprng::engine eng(nident, npart << 40);
+        for (icount = npart << 40; icount < (npart << 40) + 10; icount++)
+        {
+            make_prn(&process_data, &thread_data, icount, &iprn);
+            assert(eng.tell() == icount);
+            assert(eng() == iprn);
+            assert(eng(icount) == iprn);
+            assert(eng.uniform(icount) == get_uniform_prn(&process_data, &thread_data, icount, &iprn));
+        }
+    }
+
+    /* The reduced-round tiers */
+    initialize_individual(&process_data, &thread_data, nident);
+    desprng::engine8 e8(nident);
+    desprng::engine10 e10(nident);
+    desprng::engine12 e12(nident);
+    for (icount = 0; icount < 1000; icount++)
+    {
+        make_prn8(&process_data, &thread_data, icount, &iprn);
+        assert(e8() == iprn);
+        make_prn10(&process_data, &thread_data, icount, &iprn);
+        assert(e10() == iprn);
+        make_prn12(&process_data, &thread_data, icount, &iprn);
+        assert(e12() == iprn);
+    }
+
+    /* seek() and discard() */
+    desprng::engine a(nident), b(nident);
+    a.discard(12345);
+    b.seek(12345);
+    assert(a == b && a() == b());
+
+    /* A distribution from <random>, and a counter-based transform that could be
+       run with std::execution::par, since it does not change the engine */
+    std::normal_distribution<double> normal;
+    double sum = 0.0;
+    for (int i = 0; i < 1000; i++) sum += normal(a);
+    std::vector<std::uint64_t> counters(1000), prns(1000);
+    std::iota(counters.begin(), counters.end(), 0);
+    std::transform(counters.begin(), counters.end(), prns.begin(), [&b](std::uint64_t i) { return b(i); });
+    b.seek(0);
+    for (auto x : prns) assert(x == b());
+
+    std::printf("desprng.hpp agrees with libdesprng.a (mean of 1000 normal PRNs = %f)\n", sum / 1000);
+
+    return 0;
+}
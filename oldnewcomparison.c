@@ -1,17 +1,69 @@
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/random.h>
 
 #include "desprng.h"
 #include "d3des.h"
+#include "xisnap.h"
+
+/* Number of (identifier, counter) pairs for comparing the batch backends with make_prn() */
+#define Nbatch 1000
+
+/* The original (bitwise) key schedule in des.c, for checking the table-driven one */
+extern void _deskey(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *key);
+/* ...and the byte-wise block path, for checking the word-level one */
+extern void _des(desprng_common_t *process_data, desprng_individual_t *thread_data, unsigned char *inblock, unsigned char *outblock);
+/* ...and the permutations, for checking the PRNG-only variant */
+extern void _scrunch(unsigned char *outof, unsigned long *into);
+extern void _unscrun(unsigned long *outof, unsigned char *into);
+extern void _desip(unsigned long *block);
+extern void _desfp(unsigned long *block);
+
+/* Known answers of make_prn_np1(): particle number, counter and PRN.
+   These must never change (a new variant gets a new name instead) */
+static const unsigned long np1_answers[12][3] = {
+    {0x00000000000000UL, 0x0000000000000000UL, 0x38410FF877D41B85UL},
+    {0x00000000000000UL, 0x0000000000000001UL, 0x20B5E6EB848E5E33UL},
+    {0x00000000000000UL, 0xFEDCBA9876543210UL, 0x20DCCF8AE09CC88BUL},
+    {0x00000000000001UL, 0x0000000000000000UL, 0x4334D6F448E898EAUL},
+    {0x00000000000001UL, 0x0000000000000001UL, 0x89448502329676E7UL},
+    {0x00000000000001UL, 0xFEDCBA9876543210UL, 0xEBD8B8C3912D915EUL},
+    {0xFFFFFFFFFFFFFFUL, 0x0000000000000000UL, 0xF2C118D8EF6DBFAFUL},
+    {0xFFFFFFFFFFFFFFUL, 0x0000000000000001UL, 0x41914F9BADFCAA2EUL},
+    {0xFFFFFFFFFFFFFFUL, 0xFEDCBA9876543210UL, 0xDAE69E41406A2F08UL},
+    {0x0123456789ABCDUL, 0x0000000000000000UL, 0xE9B4C434AA1A6990UL},
+    {0x0123456789ABCDUL, 0x0000000000000001UL, 0x51CD616AB48DFAB9UL},
+    {0x0123456789ABCDUL, 0xFEDCBA9876543210UL, 0x4E0EEF6FE90221F7UL}
+};
 
 int main(int argc, char *argv[])
 {
     unsigned long nident, Ntime = 4, itime, icount, iprn;
+    double xnormals[Nbatch], xnormal[2];
+    float xfloats[Nbatch], xfloat[2];
+    int interval, inode;
+    unsigned long nfirst, nmapped, nidents[Nbatch], icounts[Nbatch], iprns[Nbatch], ibatch;
     unsigned short Ncoll = 4, icoll;
     desprng_common_t process_data;
-    desprng_individual_t thread_data;
-    FILE *d3desdump, *desprngdump;
+    desprng_individual_t thread_data, *thread_datas, *mapped_datas;
+    desprng_compact_t compact_data;
+    desprng_table_t table_data;
+    desprng_pairtable_t *pairtable_data;
+    desprng_counter_t counter;
+    desprng_numa_t numa;
+    desprng_individual_t *numa_data;
+    char *reserved;
+    double *xi;
+    const double *xmapped;
+    xisnap_t xisnap;
+    xisnap_map_t xiview;
+    xisnap_chunk_t *xichunk;
+    FILE *d3desdump, *desprngdump, *bitslicedump;
 
     assert(!(Ntime >> 48)); /* Make sure Ntime < 2**48 */
 
@@ -21,6 +73,7 @@ int main(int argc, char *argv[])
     assert(7 == getrandom(&nident, 7, GRND_RANDOM));
     /* On big-endian computers, the next line would be needed */
     /* nident >>= 8; */
+    nfirst = nident;
     assert(!create_identifier(&nident));
 
     /* deskey() does not change nident, but stores it as expanded internal (and global!) state */
@@ -28,10 +81,14 @@ int main(int argc, char *argv[])
 
     /* Initialize one of the new DES PRNG */
     initialize_common(&process_data);
+    initialize_table(&process_data, &table_data);
+    assert(pairtable_data = malloc(sizeof(desprng_pairtable_t)));
+    initialize_pairtable(&process_data, pairtable_data);
     initialize_individual(&process_data, &thread_data, nident);
 
     if (!(d3desdump = fopen("d3des.out", "w"))) return -1;
     if (!(desprngdump = fopen("desprng.out", "w"))) return -1;
+    if (!(bitslicedump = fopen("desbitslice.out", "w"))) return -1;
 
     for (itime = 0UL; itime < Ntime; itime++)
     {
@@ -48,6 +105,8 @@ int main(int argc, char *argv[])
             fprintf(d3desdump, " %016lX", iprn);
             make_prn(&process_data, &thread_data, icount, &iprn);
             fprintf(desprngdump, " %016lX", iprn);
+            nidents[ibatch = itime * Ncoll + icoll] = nident;
+            icounts[ibatch] = icount;
         }
     }
     fprintf(d3desdump, "\n");
@@ -55,5 +114,219 @@ int main(int argc, char *argv[])
     fprintf(desprngdump, "\n");
     fclose(desprngdump);
 
+    /* The bitsliced backend should reproduce desprng.out exactly */
+    make_prn_bitsliced(&process_data, Ntime * Ncoll, nidents, icounts, iprns);
+    for (itime = 0UL; itime < Ntime; itime++)
+    {
+        if (itime) fprintf(bitslicedump, "\n");
+        for (icoll = 0; icoll < Ncoll; icoll++)
+            fprintf(bitslicedump, " %016lX", iprns[itime * Ncoll + icoll]);
+    }
+    fprintf(bitslicedump, "\n");
+    fclose(bitslicedump);
+
+    /* Check the batch backends against make_prn() for a range of
+       adjacent identifiers, with one counter each */
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        nidents[ibatch] = (nfirst + ibatch) & 0x00ffffffffffffffUL;
+        icounts[ibatch] = (ibatch << 16) + 7 * ibatch;
+    }
+    assert(thread_datas = malloc(sizeof(desprng_individual_t) * Nbatch));
+    memset(thread_datas, 0xff, sizeof(desprng_individual_t) * Nbatch);
+    assert(!initialize_individuals(&process_data, thread_datas, nidents, Nbatch));
+    /* The table-driven key schedule should match the original one in _deskey(),
+       and leave no byte of the state undefined */
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        assert(!create_identifier(nidents + ibatch));
+        assert(thread_datas[ibatch].nident == nidents[ibatch]);
+        assert(!thread_datas[ibatch].KnR[ibatch % 32] && !thread_datas[ibatch].Kn3[31 - ibatch % 32]);
+        _deskey(&process_data, &thread_data, (unsigned char *)(nidents + ibatch));
+        assert(!memcmp(thread_datas[ibatch].KnL, thread_data.KnL, sizeof(thread_data.KnL)));
+    }
+    make_prn_bitsliced(&process_data, Nbatch, nidents, icounts, iprns);
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        make_prn(&process_data, thread_datas + ibatch, icounts[ibatch], &iprn);
+        assert(iprns[ibatch] == iprn);
+    }
+    make_prn_simd(&process_data, thread_datas, Nbatch, icounts, iprns);
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        make_prn(&process_data, thread_datas + ibatch, icounts[ibatch], &iprn);
+        assert(iprns[ibatch] == iprn);
+    }
+    /* ...and the range backend for consecutive counters of a single identifier */
+    desprng_fill_u64(&process_data, thread_datas, Nbatch, icounts[7], iprns);
+    desprng_fill_double(&process_data, thread_datas, Nbatch, icounts[7], xnormals);
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        assert(xnormals[ibatch] == get_uniform_prn(&process_data, thread_datas + ibatch, icounts[7], &iprn));
+        assert(iprns[ibatch] == iprn);
+    }
+    make_prn_range(&process_data, thread_datas, icounts[1], Nbatch - 1, iprns);
+    for (ibatch = 0UL; ibatch < Nbatch - 1; ibatch++)
+    {
+        make_prn(&process_data, thread_datas, icounts[1] + ibatch, &iprn);
+        assert(iprns[ibatch] == iprn);
+    }
+    /* The batched normals may use vectorized math functions, so allow for rounding */
+    get_normal_prn_range(&process_data, thread_datas, icounts[1], Nbatch / 2, xnormals);
+    for (ibatch = 0UL; ibatch < Nbatch / 2; ibatch++)
+    {
+        get_normal_prn(&process_data, thread_datas, icounts[1] + ibatch, &iprn, xnormal);
+        assert(fabs(xnormals[2 * ibatch] - xnormal[0]) < 1e-12 && fabs(xnormals[2 * ibatch + 1] - xnormal[1]) < 1e-12);
+    }
+    /* The 53-bit and float conversions, scalar and batched */
+    for (interval = DESPRNG_CLOSED_OPEN; interval <= DESPRNG_OPEN_OPEN; interval++)
+    {
+        assert(!get_uniform53_prn_range(&process_data, thread_datas, icounts[1], Nbatch, interval, xnormals));
+        for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+        {
+            assert(xnormals[ibatch] == get_uniform53_prn(&process_data, thread_datas, icounts[1] + ibatch, interval, &iprn));
+            assert(xnormals[ibatch] == (double)((iprn >> 11 | (interval == DESPRNG_OPEN_OPEN)) + (interval == DESPRNG_OPEN_CLOSED)) / 9007199254740992.0);
+            assert(xnormals[ibatch] > 0.0 || interval == DESPRNG_CLOSED_OPEN);
+            assert(xnormals[ibatch] < 1.0 || interval == DESPRNG_OPEN_CLOSED);
+        }
+    }
+    get_uniform_float_prn_range(&process_data, thread_datas, icounts[1], Nbatch / 2, xfloats);
+    for (ibatch = 0UL; ibatch < Nbatch / 2; ibatch++)
+    {
+        get_uniform_float_prn(&process_data, thread_datas, icounts[1] + ibatch, &iprn, xfloat);
+        assert(xfloats[2 * ibatch] == xfloat[0] && xfloats[2 * ibatch + 1] == xfloat[1]);
+        assert(xfloat[0] == (iprn >> 40) / 16777216.0f && xfloat[1] == ((iprn >> 8) & 0xffffff) / 16777216.0f);
+    }
+    /* A key-schedule cache file should map back to the same states, and only with its own layout */
+    assert(!desprng_write_schedules("desprng.keys", DESPRNG_LAYOUT_INDIVIDUAL, thread_datas, Nbatch, nfirst & 0x00ffffffffffffffUL));
+    assert(desprng_map_schedules("desprng.keys", DESPRNG_LAYOUT_COMPACT, (void **)&mapped_datas, &nmapped, &ibatch) == -4);
+    assert(!desprng_map_schedules("desprng.keys", DESPRNG_LAYOUT_INDIVIDUAL, (void **)&mapped_datas, &nmapped, &ibatch));
+    assert(nmapped == Nbatch && ibatch == (nfirst & 0x00ffffffffffffffUL));
+    assert(!memcmp(mapped_datas, thread_datas, sizeof(desprng_individual_t) * Nbatch));
+    make_prn_simd(&process_data, mapped_datas, Nbatch, icounts, iprns);
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        make_prn(&process_data, thread_datas + ibatch, icounts[ibatch], &iprn);
+        assert(iprns[ibatch] == iprn);
+    }
+    assert(!desprng_unmap_schedules(mapped_datas));
+    remove("desprng.keys");
+    free(thread_datas);
+
+    /* The compact state should give the same PRNs as the full one */
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        initialize_individual(&process_data, &thread_data, nidents[ibatch]);
+        initialize_compact(&process_data, &compact_data, nidents[ibatch]);
+        make_prn(&process_data, &thread_data, icounts[ibatch], &iprn);
+        _des(&process_data, &thread_data, (unsigned char *)(icounts + ibatch), (unsigned char *)iprns);
+        assert(iprns[0] == iprn && make_prn_word(&process_data, &thread_data, icounts[ibatch]) == iprn);
+        make_prn_compact(&process_data, &compact_data, icounts[ibatch], iprns);
+        assert(iprns[0] == iprn);
+        make_prn_table(&table_data, &compact_data, icounts[ibatch], iprns);
+        assert(iprns[0] == iprn);
+        make_prn_paired(pairtable_data, &compact_data, icounts[ibatch], iprns);
+        assert(iprns[0] == iprn);
+        make_prn_ident(&process_data, nidents[ibatch], icounts[ibatch], iprns);
+        assert(iprns[0] == iprn);
+    }
+    free(pairtable_data);
+
+    /* Reserved counter ranges should tile the counter space without overlaps
+       (also when reserved by many threads), and never wrap around */
+    assert(!desprng_counter_init(&counter, 0UL));
+    #pragma omp parallel for
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++) assert(!desprng_reserve(&counter, ibatch + 1, icounts + ibatch));
+    assert(reserved = calloc(Nbatch * (Nbatch + 1) / 2, 1));
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+        for (icount = icounts[ibatch]; icount < icounts[ibatch] + ibatch + 1; icount++)
+        {
+            assert(icount < Nbatch * (Nbatch + 1) / 2 && !reserved[icount]);
+            reserved[icount] = 1;
+        }
+    free(reserved);
+    assert(desprng_counter_left(&counter) == ~0UL - Nbatch * (Nbatch + 1) / 2);
+    assert(!desprng_counter_init(&counter, ~0UL - 10UL));
+    assert(!desprng_reserve(&counter, 10UL, &icount) && icount == ~0UL - 10UL);
+    assert(desprng_reserve(&counter, 1UL, &icount) == -1 && !desprng_counter_left(&counter));
+
+    /* The copies of the tables on the NUMA nodes should be the same as the
+       original, and the node-local states should start out zeroed */
+    assert(!desprng_numa_init(&numa) && numa.nnode > 0);
+    for (inode = 0; inode < numa.nnode; inode++) assert(!memcmp(numa.common[inode], &process_data, sizeof(desprng_common_t)));
+    assert(numa_data = desprng_numa_individuals(&numa, Nbatch));
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++) assert(!numa_data[ibatch].nident && !numa_data[ibatch].KnL[31]);
+    initialize_individual(desprng_numa_common(&numa), numa_data, nidents[0]);
+    make_prn(desprng_numa_common(&numa), numa_data, icounts[0], &iprn);
+    initialize_individual(&process_data, &thread_data, nidents[0]);
+    make_prn(&process_data, &thread_data, icounts[0], iprns);
+    assert(iprns[0] == iprn);
+    free(numa_data);
+    desprng_numa_free(&numa);
+
+    /* A snapshot file should read back, through the mapped reader, as written:
+       chunks written in any order, from pages (the first chunk) or not (the
+       second), a partial last chunk, and a last frame with a chunk missing */
+    assert(xisnap_open(&xisnap, "xisnap.test", 0UL, 256UL, 0.5, 1.0e-2) == -1);
+    assert(!posix_memalign((void **)&xi, XISNAP_PAGE, sizeof(double) * Nbatch));
+    assert(!xisnap_open(&xisnap, "xisnap.test", Nbatch, 256UL, 0.5, 1.0e-2));
+    for (itime = 0UL; itime < Ntime; itime++)
+    {
+        for (ibatch = 0UL; ibatch < Nbatch; ibatch++) xi[ibatch] = (double)ibatch / Nbatch - itime;
+        for (icount = xisnap.header.nchunk; icount-- > (itime == Ntime - 1); )
+            assert(!xisnap_write(&xisnap, itime, (itime + 1) * 1.0e-2, icount, xi));
+    }
+    assert(!xisnap_close(&xisnap));
+    assert(!xisnap_map(&xiview, "xisnap.test"));
+    assert(!memcmp(xiview.header, &xisnap.header, sizeof(xisnap_header_t)) && xiview.header->nchunk == 2 && xiview.nframe == Ntime);
+    for (itime = 0UL; itime < Ntime; itime++)
+    {
+        for (ibatch = 0UL; ibatch < Nbatch; ibatch++) xi[ibatch] = (double)ibatch / Nbatch - itime;
+        for (icount = 0UL; icount < xiview.header->nchunk; icount++)
+        {
+            xmapped = xisnap_chunk(&xiview, itime, icount, &xichunk);
+            if (itime == Ntime - 1 && !icount)
+            {
+                assert(!xmapped);
+                continue;
+            }
+            assert(xmapped && xichunk->iframe == itime && xichunk->t == (itime + 1) * 1.0e-2);
+            assert(xichunk->first == icount * xiview.header->chunk && xichunk->n == (icount ? Nbatch - xiview.header->chunk : xiview.header->chunk));
+            assert(!memcmp(xmapped, xi + xichunk->first, xichunk->n * sizeof(double)));
+        }
+    }
+    assert(!xisnap_chunk(&xiview, Ntime, 0UL, &xichunk));
+    assert(!xisnap_unmap(&xiview));
+    unlink("xisnap.test");
+    free(xi);
+
+    /* The PRNG-only variant should give its known answers, and be the same as
+       DES with the inverse initial permutation before and the initial
+       permutation after (i.e. without them) */
+    for (ibatch = 0UL; ibatch < 12; ibatch++)
+    {
+        nident = np1_answers[ibatch][0];
+        assert(!create_identifier(&nident));
+        initialize_individual(&process_data, &thread_data, nident);
+        make_prn_np1(&process_data, &thread_data, np1_answers[ibatch][1], &iprn);
+        assert(iprn == np1_answers[ibatch][2]);
+    }
+    for (ibatch = 0UL; ibatch < Nbatch; ibatch++)
+    {
+        initialize_individual(&process_data, &thread_data, nidents[ibatch]);
+        iprns[0] = icounts[ibatch] & 0xffffffffUL;
+        iprns[1] = icounts[ibatch] >> 32;
+        _desfp(iprns);
+        _unscrun(iprns, (unsigned char *)&icount);
+        make_prn(&process_data, &thread_data, icount, &iprn);
+        _scrunch((unsigned char *)&iprn, iprns);
+        _desip(iprns);
+        make_prn_np1(&process_data, &thread_data, icounts[ibatch], &iprn);
+        assert(iprn == (iprns[0] << 32 | (iprns[1] & 0xffffffffUL)));
+        make_prn_range_np1(&process_data, &thread_data, icounts[ibatch], 2, iprns);
+        assert(iprns[0] == iprn);
+        assert(get_uniform_prn_np1(&process_data, &thread_data, icounts[ibatch] + 1, &iprn) == iprns[1] / (1.0 + ULONG_MAX) && iprn == iprns[1]);
+    }
+
     return 0;
 }
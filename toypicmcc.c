@@ -4,17 +4,18 @@
 #include <math.h>
 
 #include "desprng.h"
+#include "xisnap.h"
 
 int main(int argc, char *argv[])
 {
-    unsigned long Npart = 400, Ntime = 4, ipart, itime, icount, iprn, *nident;
+    unsigned long Npart = 400, Ntime = 4, ipart, itime, icount, iprn, ichunk, *nident;
     unsigned short Ncoll = 2, icoll;
     desprng_common_t *process_data;
     desprng_individual_t *thread_data;
-    double xprn, zeta, czeta, zaverage = 0.0, zvariance = 0.0, dt = 1.0e-2, xt, *xi;
+    double xprn, zeta, czeta, zaverage = 0.0, zvariance = 0.0, dt = 1.0e-2, *xi;
     const double xi0 = M_SQRT1_2; /* 45 degree pitch angle */
     int ierr;
-    FILE *xidump;
+    xisnap_t xisnap;
 
     assert(!(Npart >> 56)); /* Make sure Npart < 2**56 */
     assert(!(Ntime >> 48)); /* Make sure Ntime < 2**48 */
@@ -27,14 +28,23 @@ int main(int argc, char *argv[])
         return ierr;
     }
     czeta = sqrt(12.); /* PRN normalization constant */
-    xt = Ntime * dt;
-    xidump = fopen("xi.dat", "w");
+    /* Stream the particle pitches to xi.snap after each time step, for post processing */
+    if (ierr = xisnap_open(&xisnap, "xi.snap", Npart, XISNAP_CHUNK, xi0, dt))
+    {
+        fprintf(stderr, "xisnap_open() returned the error code %d\n", ierr);
+        return ierr;
+    }
 
     /* Make some workspace on the stack for the DES PRNGs */
     nident = alloca(8 * Npart);
     thread_data = alloca(sizeof(desprng_individual_t) * Npart);
     process_data = alloca(sizeof(desprng_common_t));
-    xi = alloca(8 * Npart);
+    /* ...except for the pitches, which are written to xi.snap straight from page-aligned memory */
+    if (posix_memalign((void **)&xi, XISNAP_PAGE, 8 * Npart))
+    {
+        fprintf(stderr, "Out of memory for the pitches of %lu particles\n", Npart);
+        return 1;
+    }
 
     initialize_common(process_data);
 
@@ -78,17 +88,23 @@ int main(int argc, char *argv[])
                 xi[ipart] += -2.0 * xi[ipart] * dt / Ncoll + zeta * sqrt(2.0 * (1.0 - xi[ipart] * xi[ipart]) * dt / Ncoll);
             }
         }
+        #pragma acc update self(xi[:Npart])
+        /* Stop writing at the first error, which is reported below */
+        for (ichunk = 0UL; ichunk < xisnap.header.nchunk && !ierr; ichunk++)
+            ierr = xisnap_write(&xisnap, itime, (itime + 1) * dt, ichunk, xi);
     }
     zaverage /= Ntime * Npart * Ncoll;
     zvariance /= Ntime * Npart * Ncoll;
     printf("average = %18.16lf, variance = %18.16lf\n", zaverage, zvariance);
 
-    /* Dump the particle pitches for post processing */
-    fwrite(&Npart, 8, 1, xidump);
-    fwrite(&xi0, 8, 1, xidump);
-    fwrite(&xt, 8, 1, xidump);
-    fwrite(xi, 8, Npart, xidump);
-    fclose(xidump);
+    if (ierr)
+    {
+        fprintf(stderr, "xisnap_write() returned the error code %d\n", ierr);
+        xisnap_close(&xisnap);
+    }
+    else if (ierr = xisnap_close(&xisnap))
+        fprintf(stderr, "xisnap_close() returned the error code %d\n", ierr);
+    free(xi);
 
-    return 0;
+    return ierr;
 }
@@ -0,0 +1,195 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "desprng.h"
+#include "xisnap.h"
+
+/* OpenMP version of toypicmcc for multicore CPUs. The particles are split into
+   chunks of Nchunk, and each chunk keeps its own partial sums of zeta and
+   zeta**2, which are added up in chunk order at the end. The statistics are
+   therefore the same for any number of threads (but may differ from those of
+   toypicmcc in the last digits, since the order of summation differs).
+
+   Usage: toypicomp [Npart [Ntime [sweep]]]
+   With sweep, the run is repeated for 1, 2, 4, ... threads (up to the
+   OpenMP maximum), and the throughput in particle collisions per second is
+   reported for each thread count. Otherwise, xi.snap is written as by
+   toypicmcc, with the chunks of each frame written in parallel.
+
+   Each NUMA node has its own copy of the DES PRNG tables, and the particle
+   states are first touched on the nodes whose threads push them (with the
+   threads pinned, e.g. OMP_PROC_BIND=close, and all of them running). */
+
+#define Nchunk 256
+
+static double wtime()
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Advances all the particles Ntime time steps, writing a frame of xisnap
+   (unless NULL) after each, and returns the average and variance of zeta.
+   Each thread uses the copy of the tables on its own node. Returns 0, -2 if
+   out of memory, or the error code of the first xisnap_write() that failed */
+static int push(desprng_numa_t *numa, desprng_individual_t *thread_data, double *xi, unsigned long Npart, unsigned long Ntime,
+                 unsigned short Ncoll, double dt, xisnap_t *xisnap, double *zaverage, double *zvariance)
+{
+    unsigned long ipart, itime, ichunk, nchunk = (Npart + Nchunk - 1) / Nchunk, isnap;
+    double *zsum, *zsum2;
+    const double czeta = sqrt(12.); /* PRN normalization constant */
+    int ierr = 0;
+
+    if (!(zsum = calloc(2 * nchunk, sizeof(double)))) return -2;
+    zsum2 = zsum + nchunk;
+
+    for (itime = 0UL; itime < Ntime && !ierr; itime++)
+    {
+        #pragma omp parallel private(ipart)
+        {
+            desprng_common_t *process_data = desprng_numa_common(numa);
+
+            #pragma omp for schedule(static)
+            for (ichunk = 0UL; ichunk < nchunk; ichunk++)
+            {
+                unsigned long icount, iprn, iend = (ichunk + 1) * Nchunk < Npart ? (ichunk + 1) * Nchunk : Npart;
+                unsigned short icoll;
+                double xprn, zeta;
+
+                for (ipart = ichunk * Nchunk; ipart < iend; ipart++)
+                    for (icoll = 0; icoll < Ncoll; icoll++)
+                    {
+                        /* Make itime the high six bytes of icount, and icoll the low two bytes */
+                        icount = (itime << 16) + icoll;
+                        xprn = get_uniform_prn(process_data, thread_data + ipart, icount, &iprn);
+                        zeta = czeta * (xprn - 0.5);
+                        zsum[ichunk] += zeta;
+                        zsum2[ichunk] += zeta * zeta;
+                        xi[ipart] += -2.0 * xi[ipart] * dt / Ncoll + zeta * sqrt(2.0 * (1.0 - xi[ipart] * xi[ipart]) * dt / Ncoll);
+                    }
+            }
+        }
+        if (xisnap)
+        {
+            int ierrsnap;
+
+            #pragma omp parallel for private(ierrsnap) reduction(min: ierr) schedule(static)
+            for (isnap = 0UL; isnap < xisnap->header.nchunk; isnap++)
+                if (ierrsnap = xisnap_write(xisnap, itime, (itime + 1) * dt, isnap, xi)) ierr = ierrsnap;
+        }
+    }
+
+    *zaverage = *zvariance = 0.0;
+    for (ichunk = 0UL; ichunk < nchunk; ichunk++)
+    {
+        *zaverage += zsum[ichunk];
+        *zvariance += zsum2[ichunk];
+    }
+    *zaverage /= Ntime * Npart * Ncoll;
+    *zvariance /= Ntime * Npart * Ncoll;
+    free(zsum);
+
+    return ierr;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long Npart = 400, Ntime = 4, ipart, ichunk, *nparticle;
+    unsigned short Ncoll = 2;
+    desprng_numa_t numa;
+    desprng_individual_t *thread_data;
+    double zaverage, zvariance, dt = 1.0e-2, *xi, t0, t1;
+    const double xi0 = M_SQRT1_2; /* 45 degree pitch angle */
+    int ierr, sweep = 0, nthread = 1, maxthread = 1;
+    xisnap_t xisnap;
+
+    if (argc > 1) Npart = strtoul(argv[1], NULL, 10);
+    if (argc > 2) Ntime = strtoul(argv[2], NULL, 10);
+    if (argc > 3) sweep = !strcmp(argv[3], "sweep");
+
+    assert(!(Npart >> 56)); /* Make sure Npart < 2**56 */
+    assert(!(Ntime >> 48)); /* Make sure Ntime < 2**48 */
+
+    if (ierr = check_type_sizes())
+    {
+        fprintf(stderr, "check_type_sizes() returned the error code %d ()", ierr);
+        return ierr;
+    }
+
+    if (ierr = desprng_numa_init(&numa))
+    {
+        fprintf(stderr, "desprng_numa_init() returned the error code %d\n", ierr);
+        return ierr;
+    }
+    nparticle = malloc(sizeof(unsigned long) * Npart);
+    thread_data = desprng_numa_individuals(&numa, Npart);
+    if (!nparticle || !thread_data || posix_memalign((void **)&xi, XISNAP_PAGE, sizeof(double) * Npart))
+    {
+        fprintf(stderr, "Out of memory for %lu particles\n", Npart);
+        return 1;
+    }
+
+    /* One DES PRNG for each particle, with the particle number as identifier */
+    for (ipart = 0UL; ipart < Npart; ipart++) nparticle[ipart] = ipart;
+    if (ierr = initialize_individuals(numa.common[0], thread_data, nparticle, Npart))
+    {
+        fprintf(stderr, "initialize_individuals() returned the error code %d\n", ierr);
+        return ierr;
+    }
+
+#ifdef _OPENMP
+    maxthread = omp_get_max_threads();
+    if (!sweep) nthread = maxthread;
+#endif
+    do
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(nthread);
+#endif
+        /* Initialize the particle pitch coordinates (on the threads that push them) */
+        #pragma omp parallel for private(ipart) schedule(static)
+        for (ichunk = 0UL; ichunk < (Npart + Nchunk - 1) / Nchunk; ichunk++)
+            for (ipart = ichunk * Nchunk; ipart < Npart && ipart < (ichunk + 1) * Nchunk; ipart++) xi[ipart] = xi0;
+
+        /* Stream the particle pitches to xi.snap, as toypicmcc does */
+        if (!sweep && (ierr = xisnap_open(&xisnap, "xi.snap", Npart, XISNAP_CHUNK, xi0, dt)))
+        {
+            fprintf(stderr, "xisnap_open() returned the error code %d\n", ierr);
+            return ierr;
+        }
+        t0 = wtime();
+        ierr = push(&numa, thread_data, xi, Npart, Ntime, Ncoll, dt, sweep ? NULL : &xisnap, &zaverage, &zvariance);
+        t1 = wtime();
+        if (ierr)
+        {
+            fprintf(stderr, "push() returned the error code %d\n", ierr);
+            return ierr;
+        }
+        if (!sweep && (ierr = xisnap_close(&xisnap)))
+        {
+            fprintf(stderr, "xisnap_close() returned the error code %d\n", ierr);
+            return ierr;
+        }
+        printf("threads = %d, average = %18.16lf, variance = %18.16lf, %.4e particle collisions/s\n",
+               nthread, zaverage, zvariance, Npart * Ntime * Ncoll / (t1 - t0));
+        nthread = nthread < maxthread && 2 * nthread > maxthread ? maxthread : 2 * nthread;
+    }
+    while (sweep && nthread <= maxthread);
+
+    free(xi);
+    free(thread_data);
+    desprng_numa_free(&numa);
+    free(nparticle);
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "desprng.h"
+#include "desdriver.h"
+
+/* Version of toypicmcc with adaptive sub-cycling, on the work-stealing driver
+   of desdriver.c. In each time step, particle ipart does 1 + 7 * xi**2 (rounded
+   down) collisions, so the particles near xi = +-1 (where the pitch changes
+   fastest) cost up to eight times as much as those near xi = 0, and a static
+   split of the particles between the threads would be out of balance. The
+   counters are reserved from a desprng_counter_t per particle as they are
+   needed, and each thread has a single desprng_individual_t, which it
+   initializes for each particle it pushes, so that the state per particle is
+   only its pitch and its counter. This deliberately pays for a key schedule
+   per particle and time step (which toypicmcc does once, before the time
+   loop), in exchange for 16 bytes of state per particle instead of 792.
+
+   The average and variance of zeta are summed per chunk and added up in chunk
+   order, so the results are bit-identical for any number of threads. The run
+   is repeated for 1, 2, 4, ... threads (up to nthread, by default the number of
+   CPUs), and the statistics, a checksum of the final pitches, and the
+   throughput are printed for each, so that this can be checked.
+
+   Usage: toypicws [Npart [Ntime [nthread]]] */
+
+#define Nchunk 256
+#define Nsubmax 8
+
+typedef struct toypicws_particles
+{
+    desprng_common_t *process_data;
+    double *xi;
+    desprng_counter_t *counter;
+    double dt;
+}
+particles_t;
+
+static double wtime()
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+/* Advances the particles ibegin to iend - 1 one time step, and adds the sums
+   of zeta, zeta**2 and the number of collisions to partial */
+static void push(void *arg, desprng_individual_t *scratch, unsigned long ibegin, unsigned long iend, double *partial)
+{
+    particles_t *p = arg;
+    unsigned long ipart, nident, icount, iprn, ncoll, icoll;
+    double xprn, zeta, dt;
+    const double czeta = sqrt(12.); /* PRN normalization constant */
+
+    for (ipart = ibegin; ipart < iend; ipart++)
+    {
+        nident = ipart;
+        create_identifier(&nident);
+        initialize_individual(p->process_data, scratch, nident);
+        ncoll = 1 + (unsigned long)((Nsubmax - 1) * p->xi[ipart] * p->xi[ipart]);
+        dt = p->dt / ncoll;
+        /* Only this thread pushes ipart now, but the reservation is safe either way */
+        if (desprng_reserve(p->counter + ipart, ncoll, &icount))
+        {
+            fprintf(stderr, "desprng_reserve() ran out of counters for particle %lu\n", ipart);
+            exit(1);
+        }
+        for (icoll = 0UL; icoll < ncoll; icoll++)
+        {
+            xprn = get_uniform_prn(p->process_data, scratch, icount + icoll, &iprn);
+            zeta = czeta * (xprn - 0.5);
+            partial[0] += zeta;
+            partial[1] += zeta * zeta;
+            p->xi[ipart] += -2.0 * p->xi[ipart] * dt + zeta * sqrt(2.0 * (1.0 - p->xi[ipart] * p->xi[ipart]) * dt);
+            /* The Euler step can overshoot, and ncoll must stay finite */
+            if (p->xi[ipart] > 1.0) p->xi[ipart] = 1.0;
+            else if (p->xi[ipart] < -1.0) p->xi[ipart] = -1.0;
+        }
+        partial[2] += ncoll;
+    }
+
+    return;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long Npart = 400, Ntime = 4, ipart, itime, checksum, bits;
+    long nthread = 1, maxthread = sysconf(_SC_NPROCESSORS_ONLN);
+    particles_t p;
+    desdriver_t driver;
+    double sums[3], zsum, zsum2, ncoll, t0, t1;
+    const double xi0 = M_SQRT1_2; /* 45 degree pitch angle */
+    int ierr;
+
+    if (argc > 1) Npart = strtoul(argv[1], NULL, 10);
+    if (argc > 2) Ntime = strtoul(argv[2], NULL, 10);
+    if (argc > 3) maxthread = atol(argv[3]);
+    if (maxthread < 1) maxthread = 1;
+
+    assert(!(Npart >> 56)); /* Make sure Npart < 2**56 */
+    if (ierr = check_type_sizes())
+    {
+        fprintf(stderr, "check_type_sizes() returned the error code %d ()", ierr);
+        return ierr;
+    }
+
+    p.process_data = malloc(sizeof(desprng_common_t));
+    p.xi = malloc(sizeof(double) * Npart);
+    p.counter = malloc(sizeof(desprng_counter_t) * Npart);
+    if (!p.process_data || !p.xi || !p.counter)
+    {
+        fprintf(stderr, "Out of memory for %lu particles\n", Npart);
+        return 1;
+    }
+    p.dt = 1.0e-2;
+    initialize_common(p.process_data);
+
+    for (nthread = 1; ; nthread = 2 * nthread < maxthread ? 2 * nthread : maxthread)
+    {
+        for (ipart = 0UL; ipart < Npart; ipart++)
+        {
+            p.xi[ipart] = xi0;
+            desprng_counter_init(p.counter + ipart, 0UL);
+        }
+        if (ierr = desdriver_init(&driver, nthread, Npart, Nchunk, 3))
+        {
+            fprintf(stderr, "desdriver_init() returned the error code %d\n", ierr);
+            return 1;
+        }
+
+        zsum = zsum2 = ncoll = 0.0;
+        t0 = wtime();
+        for (itime = 0UL; itime < Ntime; itime++)
+        {
+            if (ierr = desdriver_run(&driver, push, &p, sums))
+            {
+                fprintf(stderr, "desdriver_run() returned the error code %d\n", ierr);
+                return 1;
+            }
+            zsum += sums[0];
+            zsum2 += sums[1];
+            ncoll += sums[2];
+        }
+        t1 = wtime();
+
+        for (checksum = 0UL, ipart = 0UL; ipart < Npart; ipart++)
+        {
+            memcpy(&bits, p.xi + ipart, sizeof(double));
+            checksum = (checksum << 1 | checksum >> 63) ^ bits;
+        }
+        printf("threads = %ld, average = %18.16lf, variance = %18.16lf, xi checksum = %016lX, %lu steals, %.4e particle collisions/s\n",
+               nthread, zsum / ncoll, zsum2 / ncoll, checksum, desdriver_steals(&driver), ncoll / (t1 - t0));
+        desdriver_free(&driver);
+        if (nthread == maxthread) break;
+    }
+
+    free(p.counter);
+    free(p.xi);
+    free(p.process_data);
+
+    return 0;
+}
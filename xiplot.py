@@ -1,4 +1,6 @@
-import array
+import mmap
+import struct
+import sys
 import numpy as np
 import matplotlib.pyplot as plt
 from scipy.special import legendre
@@ -10,24 +12,26 @@ xi = np.linspace(0.5 * dxi - 1.0, 1.0 - 0.5 * dxi, num=Nbin)
 
 plt.rcParams.update({'font.size': 16})
 
-unsigned_long_data = array.array('L')
-double_data = array.array('d')
-
-xidump = open('xi.dat', 'rb')
-
-unsigned_long_data.fromfile(xidump, 1)
-Npart = unsigned_long_data[0]
-print('Npart = ', Npart)
-
-double_data.fromfile(xidump, 2)
-xi0 = double_data[0]
-xt = double_data[1]
+# Map the snapshot file (see xisnap.h), and plot the frame given on the
+# command line (by default the last one, i.e. the end of the run)
+xidump = open('xi.snap', 'rb')
+xisnap = mmap.mmap(xidump.fileno(), 0, access=mmap.ACCESS_READ)
+
+magic, version, page, endian, Npart, chunk, nchunk, record, xi0, dt = struct.unpack_from('=8sIIQQQQQdd', xisnap, 0)
+assert magic == b'XISNAP\0\0' and version == 1 and endian == 0x0102030405060708
+nframe = (len(xisnap) - page + nchunk * record - 1) // (nchunk * record)
+iframe = int(sys.argv[1]) % nframe if len(sys.argv) > 1 else nframe - 1
+print('Npart = ', Npart, ', frames = ', nframe)
+
+# Gather the chunks of the frame into one array (copying each from the map)
+xidata = np.empty(Npart)
+for ichunk in range(nchunk):
+  offset = page + (iframe * nchunk + ichunk) * record
+  magic, frame, first, n, xt = struct.unpack_from('=8sQQQd', xisnap, offset)
+  assert magic == b'XICHUNK\0' and frame == iframe, 'frame %d is incomplete' % iframe
+  xidata[first:first + n] = np.frombuffer(xisnap, dtype=np.float64, count=n, offset=offset + page)
 print('xi0 = ', xi0, ', xt = ', xt)
 
-double_data.fromfile(xidump, Npart)
-xidata = np.array(double_data)
-#print(xidata)
-
 hist, bins = np.histogram(xidata, Nbin, range=(-1.0, 1.0))
 f_of_xi = np.array(hist) / (dxi * Npart)
 
@@ -47,4 +51,5 @@ plt.tight_layout()
 plt.savefig('xi.png', format = 'png')
 plt.close()
 
+xisnap.close()
 xidump.close()
@@ -0,0 +1,215 @@
+/* Particle snapshot files (xi.snap), see xisnap.h for the layout */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "xisnap.h"
+
+#define XISNAP_VERSION 1
+#define XISNAP_ENDIAN 0x0102030405060708UL
+
+/* Signatures for the internal functions */
+static int _pwrite_all(int fd, const char *buf, unsigned long nbyte, unsigned long offset);
+
+
+/* Writes all of buf at offset. If the file system turns down an O_DIRECT
+   write (with EINVAL), the rest of the file is written through the page cache */
+static int _pwrite_all(int fd, const char *buf, unsigned long nbyte, unsigned long offset)
+{
+    ssize_t nwritten;
+
+    while (nbyte)
+    {
+        if ((nwritten = pwrite(fd, buf, nbyte, offset)) < 0)
+        {
+            if (errno == EINTR) continue;
+#ifdef O_DIRECT
+            if (errno == EINVAL && fcntl(fd, F_GETFL) & O_DIRECT)
+            {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+                continue;
+            }
+#endif
+            return -1;
+        }
+        buf += nwritten;
+        nbyte -= nwritten;
+        offset += nwritten;
+    }
+
+    return 0;
+}
+
+
+/* Creates a snapshot file for Npart particles in chunks of (at most) chunk
+   particles, which is rounded up to a whole number of pages. Returns 0, or -1
+   if there are no particles or the file could not be written */
+int xisnap_open(xisnap_t *snap, const char *filename, unsigned long Npart, unsigned long chunk, double xi0, double dt)
+{
+    xisnap_header_t *header;
+    const unsigned long perpage = XISNAP_PAGE / sizeof(double);
+
+    if (!Npart) return -1;
+    if (!chunk) chunk = XISNAP_CHUNK;
+    if (chunk > Npart) chunk = Npart;
+    chunk = (chunk + perpage - 1) / perpage * perpage;
+    header = &snap->header;
+    memset(header, 0, sizeof(xisnap_header_t));
+    memcpy(header->magic, "XISNAP", 6);
+    header->version = XISNAP_VERSION;
+    header->page = XISNAP_PAGE;
+    header->endian = XISNAP_ENDIAN;
+    header->Npart = Npart;
+    header->chunk = chunk;
+    header->nchunk = (Npart + chunk - 1) / chunk;
+    header->record = XISNAP_PAGE + chunk * sizeof(double);
+    header->xi0 = xi0;
+    header->dt = dt;
+
+    /* Bypass the page cache if the file system allows it */
+#ifdef O_DIRECT
+    snap->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (snap->fd < 0)
+#endif
+        snap->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (snap->fd < 0) return -1;
+
+    /* The header page */
+    return xisnap_write(snap, ~0UL, 0.0, 0UL, NULL);
+}
+
+
+/* Writes chunk ichunk of frame iframe (at time t), i.e. the pitches
+   xi[ichunk * chunk] to xi[(ichunk + 1) * chunk - 1] (or xi[Npart - 1]).
+   Different chunks can be written at the same time by different threads.
+   Returns 0, -1 if the write failed, and -2 if out of memory */
+int xisnap_write(xisnap_t *snap, unsigned long iframe, double t, unsigned long ichunk, const double *xi)
+{
+    xisnap_header_t *header = &snap->header;
+    xisnap_chunk_t *chunk;
+    unsigned long first, n, nbyte, offset;
+    char *page, *buffer;
+    int ierr;
+
+    if (posix_memalign((void **)&page, XISNAP_PAGE, XISNAP_PAGE)) return -2;
+    memset(page, 0, XISNAP_PAGE);
+    /* The file header is written as frame ~0UL */
+    if (iframe == ~0UL)
+    {
+        memcpy(page, header, sizeof(xisnap_header_t));
+        ierr = _pwrite_all(snap->fd, page, XISNAP_PAGE, 0UL);
+        free(page);
+        return ierr;
+    }
+
+    first = ichunk * header->chunk;
+    n = header->Npart - first < header->chunk ? header->Npart - first : header->chunk;
+    nbyte = (n * sizeof(double) + XISNAP_PAGE - 1) / XISNAP_PAGE * XISNAP_PAGE;
+    offset = XISNAP_PAGE + (iframe * header->nchunk + ichunk) * header->record;
+    chunk = (xisnap_chunk_t *)page;
+    memcpy(chunk->magic, "XICHUNK", 7);
+    chunk->iframe = iframe;
+    chunk->first = first;
+    chunk->n = n;
+    chunk->t = t;
+
+    /* The pitches are written straight from xi when they fill whole, aligned pages */
+    if (!((unsigned long)(xi + first) % XISNAP_PAGE) && nbyte == n * sizeof(double))
+    {
+        ierr = _pwrite_all(snap->fd, (const char *)(xi + first), nbyte, offset + XISNAP_PAGE);
+        if (!ierr) ierr = _pwrite_all(snap->fd, page, XISNAP_PAGE, offset);
+        free(page);
+        return ierr;
+    }
+    /* ...and otherwise copied, after the chunk header, to an aligned buffer */
+    if (posix_memalign((void **)&buffer, XISNAP_PAGE, XISNAP_PAGE + nbyte))
+    {
+        free(page);
+        return -2;
+    }
+    memcpy(buffer, page, XISNAP_PAGE);
+    free(page);
+    memcpy(buffer + XISNAP_PAGE, xi + first, n * sizeof(double));
+    memset(buffer + XISNAP_PAGE + n * sizeof(double), 0, nbyte - n * sizeof(double));
+    ierr = _pwrite_all(snap->fd, buffer, XISNAP_PAGE + nbyte, offset);
+    free(buffer);
+
+    return ierr;
+}
+
+
+/* Closes a snapshot file. Returns 0, or -1 if some data could not be written */
+int xisnap_close(xisnap_t *snap)
+{
+    return close(snap->fd) ? -1 : 0;
+}
+
+
+/* Maps a snapshot file read-only. Returns 0, -1 if it could not be mapped,
+   -2 if it is not a snapshot file, and -3 if it was written with another byte
+   order or version */
+int xisnap_map(xisnap_map_t *view, const char *filename)
+{
+    struct stat st;
+    int fd;
+
+    if ((fd = open(filename, O_RDONLY)) < 0) return -1;
+    if (fstat(fd, &st))
+    {
+        close(fd);
+        return -1;
+    }
+    if ((unsigned long)st.st_size < XISNAP_PAGE)
+    {
+        close(fd);
+        return -2;
+    }
+    view->size = st.st_size;
+    view->map = mmap(NULL, view->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view->map == MAP_FAILED) return -1;
+
+    view->header = (xisnap_header_t *)view->map;
+    if (memcmp(view->header->magic, "XISNAP\0\0", 8) || !view->header->nchunk)
+    {
+        munmap(view->map, view->size);
+        return -2;
+    }
+    if (view->header->version != XISNAP_VERSION || view->header->endian != XISNAP_ENDIAN || view->header->page != XISNAP_PAGE)
+    {
+        munmap(view->map, view->size);
+        return -3;
+    }
+    /* A partial last record still counts as a (partial) frame */
+    view->nframe = (view->size - XISNAP_PAGE + view->header->nchunk * view->header->record - 1) / (view->header->nchunk * view->header->record);
+
+    return 0;
+}
+
+
+/* Returns the pitches in chunk ichunk of frame iframe of a mapped snapshot
+   file (with the chunk header in *chunk), or NULL if that chunk has not been
+   written */
+const double *xisnap_chunk(xisnap_map_t *view, unsigned long iframe, unsigned long ichunk, xisnap_chunk_t **chunk)
+{
+    unsigned long offset = XISNAP_PAGE + (iframe * view->header->nchunk + ichunk) * view->header->record;
+
+    if (iframe >= view->nframe || ichunk >= view->header->nchunk || offset + XISNAP_PAGE > view->size) return NULL;
+    *chunk = (xisnap_chunk_t *)(view->map + offset);
+    if (memcmp((*chunk)->magic, "XICHUNK\0", 8) || offset + XISNAP_PAGE + (*chunk)->n * sizeof(double) > view->size) return NULL;
+
+    return (const double *)(view->map + offset + XISNAP_PAGE);
+}
+
+
+/* Releases a mapped snapshot file */
+int xisnap_unmap(xisnap_map_t *view)
+{
+    return munmap(view->map, view->size) ? -1 : 0;
+}
@@ -0,0 +1,76 @@
+/* This is the header file for the particle snapshot files of toypicmcc and
+ * toypicomp (xi.snap), which replace the one-shot xi.dat.
+ *
+ * A snapshot file is a header page followed by frames, one per time step,
+ * each made of fixed-size chunk records. A record is a header page, with the
+ * frame number, the time and the range of particles it holds, followed by the
+ * pitches of at most chunk particles (padded to whole pages). Since the records
+ * have fixed size and offset, chunks can be written as soon as they are done,
+ * by any thread and in any order, with page-aligned (and if possible O_DIRECT)
+ * writes, and a reader can map the file and find any frame and chunk directly.
+ * All numbers are in the byte order of the writer, which is recorded in the
+ * header. xiplot.py has a reader for Python.
+ */
+
+#ifndef XISNAP_H
+#define XISNAP_H
+
+/* Page size of the file layout, and the alignment needed for O_DIRECT */
+#define XISNAP_PAGE 4096UL
+/* Default number of particles per chunk (8 MB of pitches) */
+#define XISNAP_CHUNK 1048576UL
+
+/* The file header */
+typedef struct xisnap_header
+{
+    char magic[8]; /* "XISNAP\0\0" */
+    unsigned version;
+    unsigned page;
+    unsigned long endian; /* 0x0102030405060708 in the byte order of the writer */
+    unsigned long Npart;
+    unsigned long chunk; /* Particles per chunk record */
+    unsigned long nchunk; /* Chunk records per frame */
+    unsigned long record; /* Bytes per chunk record */
+    double xi0;
+    double dt;
+}
+xisnap_header_t;
+
+/* The header of a chunk record */
+typedef struct xisnap_chunk
+{
+    char magic[8]; /* "XICHUNK\0", all zero for a chunk not yet written */
+    unsigned long iframe;
+    unsigned long first; /* The pitches of particles first, first + 1, ..., first + n - 1 follow */
+    unsigned long n;
+    double t;
+}
+xisnap_chunk_t;
+
+/* An open snapshot file, for writing */
+typedef struct xisnap_writer
+{
+    int fd;
+    xisnap_header_t header;
+}
+xisnap_t;
+
+/* A mapped snapshot file, for reading */
+typedef struct xisnap_reader
+{
+    char *map;
+    unsigned long size;
+    unsigned long nframe; /* Number of frames (the last one may be incomplete) */
+    xisnap_header_t *header;
+}
+xisnap_map_t;
+
+int xisnap_open(xisnap_t *snap, const char *filename, unsigned long Npart, unsigned long chunk, double xi0, double dt);
+int xisnap_write(xisnap_t *snap, unsigned long iframe, double t, unsigned long ichunk, const double *xi);
+int xisnap_close(xisnap_t *snap);
+
+int xisnap_map(xisnap_map_t *view, const char *filename);
+const double *xisnap_chunk(xisnap_map_t *view, unsigned long iframe, unsigned long ichunk, xisnap_chunk_t **chunk);
+int xisnap_unmap(xisnap_map_t *view);
+
+#endif